@@ -20,6 +20,10 @@ extern double BLASFUNC(ddot) (int* n,const double* a,int* lda,const double* b,
 extern void BLASFUNC(daxpy) (int *n,const double* alpha,const double* x,
 			     int* incx,double* y,int* incy);
 
+extern void BLASFUNC(dgemv) (const char* trans,int* m,int* n,double* alpha,
+			     const double* a,int* lda,const double* x,
+			     int* incx,double* beta,double* y,int* incy);
+
 extern void BLASFUNC(dsymv) (const char* uplo,int* n,double* alpha,
 			     const double* a,int* lda,const double* x,
 			     int* incx,double* beta,double* y,int* incy);
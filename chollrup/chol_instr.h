@@ -0,0 +1,240 @@
+/* -------------------------------------------------------------------
+ * Hot-path instrumentation for the Cholesky update kernels
+ *
+ * Compile with -DCHOL_INSTRUMENT to switch it on. Otherwise, the
+ * macros used in chol_kernels.h expand to nothing, and the query
+ * functions below report zero counters.
+ *
+ * For each kernel (CHOL_KUP: 'cholUpRkK', CHOL_KDN: 'cholDnRk1',
+ * CHOL_KEXCH: 'cholUpExch'), we maintain:
+ * - calls:  Number of calls
+ * - fails:  Number of calls returning != CHOL_OK
+ * - flips:  Sign flips to keep DIAG(L_) positive. For CHOL_KDN, these
+ *           are column flips of L_ (very rare), for CHOL_KEXCH row
+ *           flips of R_ (DCHEX bug workaround), for CHOL_KUP angle
+ *           flips (common)
+ * - flops:  Floating point operations in the O(n^2) and drag-along
+ *           parts (rotation: 6 per pair of elements)
+ * - bytes:  Memory traffic of these parts, assuming nothing is cached
+ * - cycles: Time stamp counter cycles (nanoseconds on platforms other
+ *           than x86) per phase: CHOL_PROTG (generation of rotations),
+ *           CHOL_PSWEEP (application to L), CHOL_PDRAG (dragging along),
+ *           CHOL_PSOLVE (DTRSV in downdate). For CHOL_KEXCH, all of
+ *           DCHEX (including the drag-along of X) counts as CHOL_PSWEEP,
+ *           the sign workaround after DCHEX as CHOL_PDRAG.
+ *           In the update kernels ('cholUpRkK', 'cholTileUpRkK'),
+ *           generation and application of rotations are interleaved per
+ *           column, so CHOL_PROTG is merged into CHOL_PSWEEP (CHOL_PROTG
+ *           is used by the downdate kernels only).
+ *           The clock is read only a few times per call
+ * - hist:   Histogram of n. Bucket i counts calls with
+ *           2^i <= n < 2^(i+1)
+ * NOTE: Each MEX file has its own set of counters.
+ *
+ * Threads:
+ * The kernels may run concurrently in several threads (pychollrup
+ * releases the GIL). All counters are updated by atomic adds, so no
+ * counts are lost. Flips are counted in a local variable and added at
+ * the next CHOL_INSTR_LAP, so the hot loops do not touch shared memory.
+ * Query and reset are not synchronized with running kernels: values
+ * returned while kernels run may be from slightly different times.
+ * -------------------------------------------------------------------
+ * Author: Matthias Seeger
+ * ------------------------------------------------------------------- */
+
+#ifndef CHOL_INSTR_H
+#define CHOL_INSTR_H
+
+#include <string.h>
+
+/* Kernels */
+#define CHOL_KUP    0
+#define CHOL_KDN    1
+#define CHOL_KEXCH  2
+#define CHOL_NKERN  3
+
+/* Phases */
+#define CHOL_PROTG  0
+#define CHOL_PSWEEP 1
+#define CHOL_PDRAG  2
+#define CHOL_PSOLVE 3
+#define CHOL_NPHASE 4
+
+#define CHOL_NHIST  32
+
+/*
+ * Number of values returned by 'cholInstrQuery'. Order:
+ * calls, fails, flips, flops, bytes, cycles[CHOL_NPHASE],
+ * hist[CHOL_NHIST]
+ */
+#define CHOL_INSTR_NVAL (5+CHOL_NPHASE+CHOL_NHIST)
+
+typedef struct {
+  unsigned long long calls,fails,flips;
+  unsigned long long flops,bytes;
+  unsigned long long cycles[CHOL_NPHASE];
+  unsigned long long hist[CHOL_NHIST];
+} chol_counters;
+
+chol_counters cholInstr[CHOL_NKERN];
+
+#ifdef CHOL_INSTRUMENT
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define cholInstrTick() ((unsigned long long) __rdtsc())
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define cholInstrTick() ((unsigned long long) __rdtsc())
+#else
+#include <time.h>
+unsigned long long cholInstrTick(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ((unsigned long long) ts.tv_sec)*1000000000ULL+ts.tv_nsec;
+}
+#endif
+
+/* Atomic add to counter (no ordering needed) */
+#if defined(_MSC_VER)
+#define cholInstrAdd(P,V) \
+  _InterlockedExchangeAdd64((volatile __int64*) (P),(__int64) (V))
+#else
+#define cholInstrAdd(P,V) \
+  __atomic_fetch_add((P),(unsigned long long) (V),__ATOMIC_RELAXED)
+#endif
+
+/*
+ * Macros used in the kernels. CHOL_INSTR_DECL goes with the local
+ * declarations (no semicolon). CHOL_INSTR_START starts the clock,
+ * CHOL_INSTR_LAP(K,P) adds the time since the last START or LAP to
+ * phase P of kernel K, and the flips counted since then.
+ */
+#define CHOL_INSTR_DECL unsigned long long cholT0_,cholT1_,cholFl_=0;
+#define CHOL_INSTR_START cholT0_=cholInstrTick()
+#define CHOL_INSTR_LAP(K,P) do { cholT1_=cholInstrTick(); \
+  cholInstrAdd(&cholInstr[K].cycles[P],cholT1_-cholT0_); cholT0_=cholT1_; \
+  if (cholFl_>0) { \
+    cholInstrAdd(&cholInstr[K].flips,cholFl_); cholFl_=0; \
+  } } while (0)
+#define CHOL_INSTR_CALL(K,N) cholInstrCall(K,N)
+#define CHOL_INSTR_FAIL(K) cholInstrAdd(&cholInstr[K].fails,1)
+#define CHOL_INSTR_FLIP(K) cholFl_++
+#define CHOL_INSTR_WORK(K,FL,BY) do { \
+  cholInstrAdd(&cholInstr[K].flops,FL); \
+  cholInstrAdd(&cholInstr[K].bytes,BY); } while (0)
+
+void cholInstrCall(int kern,int n)
+{
+  int i;
+
+  cholInstrAdd(&cholInstr[kern].calls,1);
+  for (i=0; i<CHOL_NHIST-1 && (n>>(i+1))>0; i++);
+  cholInstrAdd(&cholInstr[kern].hist[i],1);
+}
+
+#else
+
+/* No-ops. Can be used as statements (also as body of 'if') */
+#define CHOL_INSTR_DECL
+#define CHOL_INSTR_START ((void) 0)
+#define CHOL_INSTR_LAP(K,P) ((void) 0)
+#define CHOL_INSTR_CALL(K,N) ((void) 0)
+#define CHOL_INSTR_FAIL(K) ((void) 0)
+#define CHOL_INSTR_FLIP(K) ((void) 0)
+#define CHOL_INSTR_WORK(K,FL,BY) ((void) 0)
+
+#endif
+
+/*
+ * Exported functions
+ */
+
+void cholInstrReset(void)
+{
+  memset(cholInstr,0,CHOL_NKERN*sizeof(chol_counters));
+}
+
+/*
+ * Writes the counters of kernel 'kern' to 'vals' (size CHOL_INSTR_NVAL).
+ */
+void cholInstrQuery(int kern,double* vals)
+{
+  int i;
+  const chol_counters* cnt=cholInstr+kern;
+
+  vals[0]=(double) cnt->calls; vals[1]=(double) cnt->fails;
+  vals[2]=(double) cnt->flips; vals[3]=(double) cnt->flops;
+  vals[4]=(double) cnt->bytes;
+  for (i=0; i<CHOL_NPHASE; i++)
+    vals[5+i]=(double) cnt->cycles[i];
+  for (i=0; i<CHOL_NHIST; i++)
+    vals[5+CHOL_NPHASE+i]=(double) cnt->hist[i];
+}
+
+/*
+ * Prints the counters of all kernels, using 'prt' (printf, mexPrintf).
+ */
+void cholInstrDump(int (*prt)(const char*,...))
+{
+  int k,i;
+  const chol_counters* cnt;
+  const char* kname[]={"update","downdate","exchange"};
+
+#ifndef CHOL_INSTRUMENT
+  prt("Instrumentation disabled (compile with -DCHOL_INSTRUMENT)\n");
+#endif
+  for (k=0; k<CHOL_NKERN; k++) {
+    cnt=cholInstr+k;
+    prt("%s: calls=%llu, fails=%llu, flips=%llu, flops=%.6g, bytes=%.6g\n",
+	kname[k],cnt->calls,cnt->fails,cnt->flips,(double) cnt->flops,
+	(double) cnt->bytes);
+    prt("  cycles: rotg=%llu, sweep=%llu, drag=%llu, solve=%llu\n",
+	cnt->cycles[CHOL_PROTG],cnt->cycles[CHOL_PSWEEP],
+	cnt->cycles[CHOL_PDRAG],cnt->cycles[CHOL_PSOLVE]);
+    for (i=0; i<CHOL_NHIST; i++)
+      if (cnt->hist[i]>0)
+	prt("  n in [%llu,%llu): %llu\n",1ULL<<i,1ULL<<(i+1),cnt->hist[i]);
+  }
+}
+
+#ifdef MEX_HELPER_H
+/*
+ * Instrumentation commands for MEX functions. If the first argument
+ * is a string, it is one of:
+ * - 'stats': Returns CHOL_INSTR_NVAL-by-CHOL_NKERN matrix of counters,
+ *            one column per kernel (order of 'cholInstrQuery')
+ * - 'reset': Resets all counters
+ * - 'dump':  Prints all counters
+ * Returns false if the first argument is not a string.
+ */
+bool cholInstrMexCmd(int nlhs,mxArray *plhs[],int nrhs,
+		     const mxArray *prhs[])
+{
+  int k;
+  const char* cmd;
+
+  if (nrhs<1 || !mxIsChar(prhs[0]))
+    return false;
+  cmd=getString(prhs[0],"CMD");
+  if (strcmp(cmd,"stats")==0) {
+    plhs[0]=mxCreateDoubleMatrix(CHOL_INSTR_NVAL,CHOL_NKERN,mxREAL);
+    for (k=0; k<CHOL_NKERN; k++)
+      cholInstrQuery(k,mxGetPr(plhs[0])+(k*CHOL_INSTR_NVAL));
+  } else if (strcmp(cmd,"reset")==0)
+    cholInstrReset();
+  else if (strcmp(cmd,"dump")==0)
+    cholInstrDump(mexPrintf);
+  else {
+    mxFree((void*) cmd);
+    mexErrMsgTxt("Unknown command (use 'stats', 'reset', 'dump')");
+  }
+  mxFree((void*) cmd);
+
+  return true;
+}
+#endif
+
+#endif
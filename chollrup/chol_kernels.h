@@ -0,0 +1,349 @@
+/* -------------------------------------------------------------------
+ * Cholesky update kernels
+ *
+ * Core code behind CHOLUPRK1, CHOLDNRK1, CHOLUPEXCH and CHOLSTREAM.
+ * The functions here do not depend on the MEX interface, they operate
+ * on plain BLAS-style matrices (buffer, leading dimension). Argument
+ * checking is done by the callers. Variants operating on tiled storage
+ * are in chol_tiled.h.
+ *
+ * The update/downdate methods are adapted from LINPACK dchud, dchdd.
+ * We did the following modifications:
+ * - Using BLAS drot in order to avoid any explicit O(n^2) loops
+ * - Keeping diag(L_) positive, by flipping angles c_k, s_k (update)
+ *   or columns of L_ (downdate) whenever a negative element pops up
+ * See the TR
+ *   M. Seeger
+ *   Low Rank Updates for the Cholesky Decomposition
+ *   Available at: www.kyb.tuebingen.mpg.de/bs/people/seeger/papers/
+ * -------------------------------------------------------------------
+ * Author: Matthias Seeger
+ * ------------------------------------------------------------------- */
+
+#ifndef CHOL_KERNELS_H
+#define CHOL_KERNELS_H
+
+#include <math.h>
+#include <stdlib.h>
+
+#ifndef BLASFUNC
+#define BLASFUNC(NAME) NAME ## _
+#endif
+
+#include "blas_headers.h"
+#include "chol_instr.h"
+
+/* LINPACK DCHEX declaration */
+extern void BLASFUNC(dchex) (double* r,int* ldr,int* p,int* k,int* l,
+			     double* z,int* ldz,int* nz,double* c,double* s,
+			     int* job);
+
+/*
+ * Return codes of the kernels. CHOL_NOTPD is returned by 'cholDnRk1'
+ * if A - v*v' is not positive definite. This is detected before L is
+ * touched, so that L and Z are left unchanged in this case. After
+ * CHOL_NUMERR (also returned if a work array cannot be allocated), the
+ * content of L and Z is undefined.
+ */
+#define CHOL_OK     0
+#define CHOL_NUMERR 1
+#define CHOL_NOTPD  2
+
+/*
+ * Dragging along for 'cholUpRkK' (and its tiled variant): Z (r-by-n) is
+ * rotated against the columns of Y (r-by-k), using the rotations in
+ * CVEC, SVEC. Z(i,j) is zbuff[i*incz+j*ldz].
+ */
+void cholUpDrag(int n,int k,const double* cvec,const double* svec,
+		double* wkvec,double* zbuff,int r,int ldz,int incz,
+		const double* ymat)
+{
+  int i,j,ione=1,nk=r*k;
+  double* zcol;
+
+  BLASFUNC(dcopy) (&nk,ymat,&ione,wkvec,&ione);
+  for (i=0; i<n; i++) {
+    zcol=zbuff+(i*ldz);
+    for (j=0; j<k; j++)
+      BLASFUNC(drot) (&r,zcol,&incz,wkvec+(j*r),&ione,cvec+(j*n+i),
+		      svec+(j*n+i));
+  }
+}
+
+/*
+ * Dragging along for 'cholDnRk1' (and its tiled variant). If 'flip' is
+ * given, flip[i]!=0 iff column i of L_ has been flipped. Z as for
+ * 'cholUpDrag'.
+ */
+void cholDnDrag(int n,const double* cvec,const double* svec,
+		const int* flip,double* wkvec,double* zbuff,int r,int ldz,
+		int incz,const double* yvec)
+{
+  int i,ione=1;
+  double qs,cval,sval,c1,c2;
+  double* zcol;
+
+  BLASFUNC(dcopy) (&r,yvec,&ione,wkvec,&ione);
+  for (i=0; i<n; i++) {
+    zcol=zbuff+(i*ldz);
+    cval=cvec[i]; sval=svec[i];
+    qs=-sval;
+    BLASFUNC(daxpy) (&r,&qs,wkvec,&ione,zcol,&incz);
+    if (flip!=0 && flip[i]!=0) {
+      c1=-1.0/cval; c2=sval;
+    } else {
+      c1=1.0/cval; c2=-sval;
+    }
+    BLASFUNC(dscal) (&r,&c1,zcol,&incz);
+    if (i<n-1) {
+      BLASFUNC(dscal) (&r,&cval,wkvec,&ione);
+      BLASFUNC(daxpy) (&r,&c2,zcol,&incz,wkvec,&ione);
+    }
+  }
+}
+
+/*
+ * Rank k update (k >= 1)
+ *   A_ = A + V*V' = L_ L_',  V = [v_1 ... v_k] n-by-k.
+ * This is the same as k rank one updates by v_1, ..., v_k in turn, but
+ * the columns of L are swept only once: column i is rotated against
+ * all v_j while it is in cache.
+ * L (or L', if 'islower'==0) in 'lbuff', leading dim. 'ldl'. V in
+ * 'vmat' (leading dim. n), may be the same as 'wkvec'. Rotations for
+ * v_j are written to cvec[j*n+i], svec[j*n+i], so CVEC, SVEC need size
+ * n*k. Working vector 'wkvec' of size k*max(n,r).
+ * Dragging along: If r>0, Z (r-by-n, leading dim. 'ldz', row stride
+ * 'incz') is overwritten by Z_, where
+ *   Z_ L_' = Z L' + Y V',  Y = [y_1 ... y_k] r-by-k in 'ymat' (leading
+ * dim. r).
+ * Z(i,j) is zbuff[i*incz+j*ldz], so a row-major Z is passed with
+ * ldz = 1, incz = its leading dim. (incz = 1 for column-major Z).
+ */
+int cholUpRkK(double* lbuff,int n,int ldl,int islower,int k,
+	      const double* vmat,double* cvec,double* svec,double* wkvec,
+	      double* zbuff,int r,int ldz,int incz,const double* ymat)
+{
+  int i,j,stp,sz,ione=1,nk,retcode=CHOL_OK;
+  double temp;
+  double* tbuff,*cval,*sval;
+  CHOL_INSTR_DECL
+
+  CHOL_INSTR_CALL(CHOL_KUP,n);
+  CHOL_INSTR_START;
+  /* Generate Givens rotations, update L */
+  nk=n*k;
+  BLASFUNC(dcopy) (&nk,vmat,&ione,wkvec,&ione);
+  stp=islower?1:ldl;
+  for (i=0,sz=n-1,tbuff=lbuff; i<n && retcode==CHOL_OK;
+       i++,sz--,tbuff+=(ldl+1))
+    for (j=0; j<k; j++) {
+      cval=cvec+(j*n+i); sval=svec+(j*n+i);
+      /* drotg(a,b,c,s): J = [c s; -s c], s.t. J [a; b] = [r; 0]
+	 a overwritten by r, b by some other information (NOT 0!) */
+      if (*tbuff==0.0 && wkvec[j*n+i]==0.0) {
+	retcode=CHOL_NUMERR; break;
+      }
+      BLASFUNC(drotg) (tbuff,wkvec+(j*n+i),cval,sval);
+      /* Do not want negative elements on factor diagonal */
+      if ((temp=*tbuff)<0.0) {
+	*tbuff=-temp; *cval=-(*cval); *sval=-(*sval);
+	CHOL_INSTR_FLIP(CHOL_KUP);
+      } else if (temp==0.0) {
+	retcode=CHOL_NUMERR; break;
+      }
+      /* drot(x,y,c,s): J = [c s; -s c]. [x_i; y_i] overwritten by
+	 J [x_i; y_i], for all i
+	 BAD: Slower for upper triangular! */
+      if (sz>0)
+	BLASFUNC(drot) (&sz,tbuff+stp,&stp,wkvec+(j*n+i+1),&ione,cval,sval);
+    }
+  /* Generation and application of rotations are interleaved per
+     column, both are timed as CHOL_PSWEEP */
+  CHOL_INSTR_LAP(CHOL_KUP,CHOL_PSWEEP);
+  if (retcode!=CHOL_OK) {
+    CHOL_INSTR_FAIL(CHOL_KUP);
+    return retcode;
+  }
+  /* k*n*(n-1)/2 rotated pairs */
+  CHOL_INSTR_WORK(CHOL_KUP,3.0*k*n*(n-1),16.0*k*n*(n-1));
+
+  /* Dragging along */
+  if (r>0) {
+    cholUpDrag(n,k,cvec,svec,wkvec,zbuff,r,ldz,incz,ymat);
+    CHOL_INSTR_LAP(CHOL_KUP,CHOL_PDRAG);
+    CHOL_INSTR_WORK(CHOL_KUP,6.0*k*n*r,32.0*k*n*r);
+  }
+
+  return CHOL_OK;
+}
+
+/*
+ * Rank one update
+ *   A_ = A + v*v' = L_ L_'
+ * Special case k=1 of 'cholUpRkK'. 'vvec' and 'wkvec' can be the same.
+ */
+int cholUpRk1(double* lbuff,int n,int ldl,int islower,const double* vvec,
+	      double* cvec,double* svec,double* wkvec,double* zbuff,int r,
+	      int ldz,int incz,const double* yvec)
+{
+  return cholUpRkK(lbuff,n,ldl,islower,1,vvec,cvec,svec,wkvec,zbuff,r,ldz,
+		   incz,yvec);
+}
+
+/*
+ * Rank one downdate
+ *   A_ = A - v*v' = L_ L_'
+ * Arguments as for 'cholUpRk1'. If 'isp'!=0, 'vvec' contains p = L\v
+ * rather than v. Dragging along: Z_ L_' = Z L' - y v'.
+ * Returns CHOL_NOTPD (L, Z unchanged) if A_ is not positive definite.
+ */
+int cholDnRk1(double* lbuff,int n,int ldl,int islower,const double* vvec,
+	      int isp,double* cvec,double* svec,double* wkvec,double* zbuff,
+	      int r,int ldz,int incz,const double* yvec)
+{
+  int i,stp,sz,ione=1,retcode=CHOL_OK;
+  double qs;
+  double* tbuff;
+  int* flip=0;
+  CHOL_INSTR_DECL
+
+  CHOL_INSTR_CALL(CHOL_KDN,n);
+  CHOL_INSTR_START;
+  /* Compute p (if not given) */
+  BLASFUNC(dcopy) (&n,vvec,&ione,wkvec,&ione);
+  if (!isp) {
+    BLASFUNC(dtrsv) (islower?"L":"U",islower?"N":"T","N",&n,lbuff,&ldl,
+		     wkvec,&ione);
+    CHOL_INSTR_LAP(CHOL_KDN,CHOL_PSOLVE);
+    CHOL_INSTR_WORK(CHOL_KDN,1.0*n*n,4.0*n*(n+1)+16.0*n);
+  }
+  /* Generate Givens rotations */
+  qs=1.0-BLASFUNC(ddot) (&n,wkvec,&ione,wkvec,&ione);
+  if (qs<=0.0) {
+    CHOL_INSTR_FAIL(CHOL_KDN);
+    return CHOL_NOTPD;
+  }
+  qs=sqrt(qs);
+  for (i=n-1; i>=0; i--) {
+    BLASFUNC(drotg) (&qs,wkvec+i,cvec+i,svec+i);
+    /* 'qs' must remain positive */
+    if (qs<0.0) {
+      qs=-qs; cvec[i]=-cvec[i]; svec[i]=-svec[i];
+    }
+  }
+  /* NOTE: 'qs' should be 1 now */
+  CHOL_INSTR_LAP(CHOL_KDN,CHOL_PROTG);
+
+  /* Update L. If there are any flips of L_ cols, we alloc. 'flip' and
+     mark them there */
+  for (i=0; i<n; i++) wkvec[i]=0.0;
+  stp=islower?1:ldl;
+  for (i=n-1,sz=0,tbuff=lbuff+((n-1)*(ldl+1)); i>=0; i--) {
+    /* BAD: Slower for upper triangular! */
+    sz++;
+    if (*tbuff<=0.0) {
+      retcode=CHOL_NUMERR; break;
+    }
+    BLASFUNC(drot) (&sz,wkvec+i,&ione,tbuff,&stp,cvec+i,svec+i);
+    /* Do not want negative elements on diagonal */
+    if (*tbuff<0.0) {
+      if (flip==0 && (flip=(int*) calloc(n,sizeof(int)))==0) {
+	/* Does this ever happen? Out of memory: L_ is undefined */
+	retcode=CHOL_NUMERR; break;
+      }
+      flip[i]=1;
+      CHOL_INSTR_FLIP(CHOL_KDN);
+      qs=-1.0;
+      BLASFUNC(dscal) (&sz,&qs,tbuff,&stp);
+    } else if (*tbuff==0.0) {
+      retcode=CHOL_NUMERR; break;
+    }
+    tbuff-=(ldl+1);
+  }
+  /* NOTE: Should have v in 'wkvec' now */
+  CHOL_INSTR_LAP(CHOL_KDN,CHOL_PSWEEP);
+  /* n*(n+1)/2 rotated pairs */
+  CHOL_INSTR_WORK(CHOL_KDN,3.0*n*(n+1),16.0*n*(n+1));
+
+  /* Dragging along */
+  if (r>0 && retcode==CHOL_OK) {
+    cholDnDrag(n,cvec,svec,flip,wkvec,zbuff,r,ldz,incz,yvec);
+    CHOL_INSTR_LAP(CHOL_KDN,CHOL_PDRAG);
+    CHOL_INSTR_WORK(CHOL_KDN,6.0*n*r,80.0*n*r);
+  }
+  if (flip!=0) free((void*) flip);
+  if (retcode!=CHOL_OK)
+    CHOL_INSTR_FAIL(CHOL_KDN);
+
+  return retcode;
+}
+
+/*
+ * Exchange update
+ *   A_ = E' A E = R_' R_,  R_ = U R E
+ * R upper triangular in 'rbuff', leading dim. 'ldr'. E is determined by
+ * K, L, JOB (1-based, 1 <= K < L <= n), see CHOLUPEXCH. CVEC, SVEC need
+ * size n.
+ * Dragging along:
+ * - If nz>0, X (n-by-nz, leading dim. 'ldx', row stride 'incx') is
+ *   replaced by X_ = U X (CHOLUPEXCH convention)
+ * - If r>0, Z (r-by-n, leading dim. 'ldz', row stride 'incz') is
+ *   replaced by Z_ = Z U', so that Z_ R_ = Z R E (CHOLUPRK1 convention)
+ * DCHEX only accepts X with incx = 1. Otherwise, the rotations are
+ * applied to X here.
+ * NOTE: There is a bug in DCHEX, causing elements of DIAG(R_) to be
+ * negative. We include a workaround here.
+ */
+int cholUpExch(double* rbuff,int n,int ldr,int k,int l,int job,
+	       double* xbuff,int ldx,int incx,int nz,double* zbuff,int r,
+	       int ldz,int incz,double* cvec,double* svec)
+{
+  int i,j,a,lmk,farg1,nzd;
+  double temp;
+  CHOL_INSTR_DECL
+
+  CHOL_INSTR_CALL(CHOL_KEXCH,n);
+  CHOL_INSTR_START;
+  /* Call DCHEX */
+  nzd=(incx==1)?nz:0;
+  BLASFUNC(dchex) (rbuff,&ldr,&n,&k,&l,xbuff,&ldx,&nzd,cvec,svec,&job);
+  lmk=l-k;
+  /* U(i) acts in plane (a,a+1) (0-based a), U(1) comes first */
+  for (i=0; i<lmk && nzd<nz; i++) {
+    a=(job==1)?(l-i-2):(k+i-1);
+    BLASFUNC(drot) (&nz,xbuff+(a*incx),&ldx,xbuff+((a+1)*incx),&ldx,
+		    cvec+i,svec+i);
+  }
+  CHOL_INSTR_LAP(CHOL_KEXCH,CHOL_PSWEEP);
+  /* Rotated pairs in R: lmk*(lmk-1)/2+(n-l+1)*lmk (JOB=1),
+     lmk*(lmk+1)/2+(n-l)*lmk (JOB=2) */
+  CHOL_INSTR_WORK(CHOL_KEXCH,3.0*lmk*(2*n-2*l+lmk+1)+6.0*lmk*nz,
+		  16.0*lmk*(2*n-2*l+lmk+1)+32.0*lmk*nz);
+  if (r>0)
+    for (i=0; i<lmk; i++) {
+      a=(job==1)?(l-i-2):(k+i-1);
+      BLASFUNC(drot) (&r,zbuff+(a*ldz),&incz,zbuff+((a+1)*ldz),&incz,
+		      cvec+i,svec+i);
+    }
+  /* There is a strange bug in DCHEX. In some cases,
+     R(j,j) < 0 for some k<=j<=l, the whole corr. row has to be multiplied
+     by -1 to get the correct Cholesky factor. Here is a workaround. */
+  for (j=k; j<=l; j++)
+    if (rbuff[(j-1)*(ldr+1)]<0) {
+      farg1=n-j+1; temp=-1.0;
+      BLASFUNC(dscal) (&farg1,&temp,rbuff+((j-1)*(ldr+1)),&ldr);
+      if (nz!=0)
+	BLASFUNC(dscal) (&nz,&temp,xbuff+((j-1)*incx),&ldx);
+      if (r>0)
+	BLASFUNC(dscal) (&r,&temp,zbuff+((j-1)*ldz),&incz);
+      CHOL_INSTR_FLIP(CHOL_KEXCH);
+    }
+  /* Also adds the flips of the workaround */
+  CHOL_INSTR_LAP(CHOL_KEXCH,CHOL_PDRAG);
+  if (r>0)
+    CHOL_INSTR_WORK(CHOL_KEXCH,6.0*lmk*r,32.0*lmk*r);
+
+  return CHOL_OK;
+}
+
+#endif
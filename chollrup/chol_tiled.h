@@ -0,0 +1,520 @@
+/* -------------------------------------------------------------------
+ * Tiled (blocked) storage of Cholesky factors, and update kernels
+ * operating on it
+ *
+ * In column-major storage, rank one updates of a lower triangular L
+ * access contiguous columns, but updates of an upper triangular R are
+ * strided, and DCHEX walks R with mixed row and column access. Once
+ * the factor does not fit into the cache anymore, this is slow.
+ *
+ * Tiled format:
+ * The tiled buffer always holds the lower triangular factor L (for an
+ * upper triangular R, it holds L = R'). L is partitioned into nb-by-nb
+ * tiles (I,J), I >= J, nt = ceil(n/nb) tiles per row/column. Each tile
+ * is stored contiguously in column-major order (leading dim. nb), tiles
+ * are ordered by tile column J, then I. Tiles at the lower/right border
+ * are padded. The buffer has size nt*(nt+1)/2*nb*nb, see 'cholTileSize'.
+ * The kernels sweep over L tile by tile: the rotations generated from a
+ * tile column are applied to each tile below while it is in cache. All
+ * vectors (V, Z, X) are in normal (strided) storage, see 'cholUpRkK'.
+ * NOTE: A column-major lower triangular L with leading dim. ldl is a
+ * tiled buffer with nb = ldl (a single tile), so the kernels here can
+ * be used for such L as well.
+ *
+ * Kernels (same semantics as in chol_kernels.h):
+ * - 'cholTileUpRkK', 'cholTileUpRk1': Update, see 'cholUpRkK'
+ * - 'cholTileDnRk1': Downdate, see 'cholDnRk1'
+ * - 'cholTileUpExch': Exchange, see 'cholUpExch'. Works on L = R'.
+ *   This is a port of LINPACK DCHEX to the tiled format
+ * -------------------------------------------------------------------
+ * Author: Matthias Seeger
+ * ------------------------------------------------------------------- */
+
+#ifndef CHOL_TILED_H
+#define CHOL_TILED_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "chol_kernels.h"
+
+/*
+ * Size (number of doubles) of tiled buffer
+ */
+size_t cholTileSize(int n,int nb)
+{
+  size_t nt=(n+nb-1)/nb;
+
+  return nt*(nt+1)/2*nb*nb;
+}
+
+/*
+ * Returns pointer to tile (ti,tj), ti >= tj
+ */
+double* cholTilePtr(double* tbuff,int n,int nb,int ti,int tj)
+{
+  size_t nt=(n+nb-1)/nb;
+
+  return tbuff+((tj*nt-((size_t) tj)*(tj-1)/2+(ti-tj))*nb)*nb;
+}
+
+/*
+ * Returns pointer to element (i,j), i >= j (0-based)
+ */
+double* cholTileElem(double* tbuff,int n,int nb,int i,int j)
+{
+  return cholTilePtr(tbuff,n,nb,i/nb,j/nb)+((i%nb)+(j%nb)*nb);
+}
+
+/*
+ * Copies factor (column-major in 'abuff', leading dim. 'lda') into
+ * tiled buffer 'tbuff'. Only the triangle given by 'islower' is
+ * accessed. An upper triangular R is stored as R'.
+ */
+void cholTileFromCM(double* tbuff,int n,int nb,const double* abuff,int lda,
+		    int islower)
+{
+  int i,j,ione=1,sz;
+  double* tcol;
+
+  memset(tbuff,0,cholTileSize(n,nb)*sizeof(double));
+  for (j=0; j<n; j++)
+    for (i=j; i<n; i+=sz) {
+      /* Part of column j in tile row i/nb */
+      sz=((i/nb+1)*nb<n)?((i/nb+1)*nb-i):(n-i);
+      tcol=cholTileElem(tbuff,n,nb,i,j);
+      if (islower)
+	BLASFUNC(dcopy) (&sz,abuff+(i+j*lda),&ione,tcol,&ione);
+      else
+	BLASFUNC(dcopy) (&sz,abuff+(j+i*lda),&lda,tcol,&ione);
+    }
+}
+
+/*
+ * Inverse of 'cholTileFromCM'. Only the triangle given by 'islower' is
+ * written.
+ */
+void cholTileToCM(double* tbuff,int n,int nb,double* abuff,int lda,
+		  int islower)
+{
+  int i,j,ione=1,sz;
+  double* tcol;
+
+  for (j=0; j<n; j++)
+    for (i=j; i<n; i+=sz) {
+      sz=((i/nb+1)*nb<n)?((i/nb+1)*nb-i):(n-i);
+      tcol=cholTileElem(tbuff,n,nb,i,j);
+      if (islower)
+	BLASFUNC(dcopy) (&sz,tcol,&ione,abuff+(i+j*lda),&ione);
+      else
+	BLASFUNC(dcopy) (&sz,tcol,&ione,abuff+(j+i*lda),&lda);
+    }
+}
+
+/*
+ * Writes column j of L to 'col' (size n), with zeros above the diagonal
+ */
+void cholTileGetCol(double* tbuff,int n,int nb,int j,double* col)
+{
+  int i,sz,ione=1;
+
+  for (i=0; i<j; i++) col[i]=0.0;
+  for (i=j; i<n; i+=sz) {
+    sz=((i/nb+1)*nb<n)?((i/nb+1)*nb-i):(n-i);
+    BLASFUNC(dcopy) (&sz,cholTileElem(tbuff,n,nb,i,j),&ione,col+i,&ione);
+  }
+}
+
+/*
+ * Applies rotation [c s; -s c] to rows i0,...,n-1 of columns (ja, jb)
+ * of L (i0 >= jb > ja)
+ */
+void cholTileRotCols(double* tbuff,int n,int nb,int i0,int ja,int jb,
+		     const double* c,const double* s)
+{
+  int i,sz,ione=1;
+
+  for (i=i0; i<n; i+=sz) {
+    sz=((i/nb+1)*nb<n)?((i/nb+1)*nb-i):(n-i);
+    BLASFUNC(drot) (&sz,cholTileElem(tbuff,n,nb,i,ja),&ione,
+		    cholTileElem(tbuff,n,nb,i,jb),&ione,c,s);
+  }
+}
+
+/*
+ * Scales rows i0,...,n-1 of column j of L by 'alpha'
+ */
+void cholTileScalCol(double* tbuff,int n,int nb,int i0,int j,double alpha)
+{
+  int i,sz,ione=1;
+
+  for (i=i0; i<n; i+=sz) {
+    sz=((i/nb+1)*nb<n)?((i/nb+1)*nb-i):(n-i);
+    BLASFUNC(dscal) (&sz,&alpha,cholTileElem(tbuff,n,nb,i,j),&ione);
+  }
+}
+
+/*
+ * Moves rows i0,...,i1-1 of column j of L one position down (if 'down')
+ * or up
+ */
+void cholTileShiftCol(double* tbuff,int n,int nb,int j,int i0,int i1,
+		      int down)
+{
+  int a,b;
+  double* tp;
+
+  if (down)
+    for (b=i1; b>i0; b=a) {
+      /* Segment [a,b) within one tile */
+      a=((b-1)/nb)*nb;
+      if (a<i0) a=i0;
+      tp=cholTileElem(tbuff,n,nb,a,j);
+      if (b%nb==0) {
+	/* Last element goes to next tile */
+	*cholTileElem(tbuff,n,nb,b,j)=tp[b-1-a];
+	memmove(tp+1,tp,(b-1-a)*sizeof(double));
+      } else
+	memmove(tp+1,tp,(b-a)*sizeof(double));
+    }
+  else
+    for (a=i0; a<i1; a=b) {
+      b=(a/nb+1)*nb;
+      if (b>i1) b=i1;
+      tp=cholTileElem(tbuff,n,nb,a,j);
+      if (a%nb==0) {
+	/* First element goes to previous tile */
+	*cholTileElem(tbuff,n,nb,a-1,j)=*tp;
+	memmove(tp,tp+1,(b-1-a)*sizeof(double));
+      } else
+	memmove(tp-1,tp,(b-a)*sizeof(double));
+    }
+}
+
+/*
+ * Rank k update on tiled L, see 'cholUpRkK'
+ */
+int cholTileUpRkK(double* tbuff,int n,int nb,int k,const double* vmat,
+		  double* cvec,double* svec,double* wkvec,double* zbuff,
+		  int r,int ldz,int incz,const double* ymat)
+{
+  int i,j,c,ti,tj,nt,i0,j0,mi,mj,sz,ione=1,nk,retcode=CHOL_OK;
+  double temp;
+  double* dtile,*tile,*tp,*cval,*sval;
+  CHOL_INSTR_DECL
+
+  CHOL_INSTR_CALL(CHOL_KUP,n);
+  CHOL_INSTR_START;
+  nk=n*k;
+  BLASFUNC(dcopy) (&nk,vmat,&ione,wkvec,&ione);
+  nt=(n+nb-1)/nb;
+  for (tj=0; tj<nt && retcode==CHOL_OK; tj++) {
+    j0=tj*nb; mj=(j0+nb<n)?nb:(n-j0);
+    dtile=cholTilePtr(tbuff,n,nb,tj,tj);
+    /* Generate Givens rotations, update diagonal tile */
+    for (c=0,tp=dtile; c<mj && retcode==CHOL_OK; c++,tp+=(nb+1)) {
+      i=j0+c; sz=mj-c-1;
+      for (j=0; j<k; j++) {
+	cval=cvec+(j*n+i); sval=svec+(j*n+i);
+	if (*tp==0.0 && wkvec[j*n+i]==0.0) {
+	  retcode=CHOL_NUMERR; break;
+	}
+	BLASFUNC(drotg) (tp,wkvec+(j*n+i),cval,sval);
+	/* Do not want negative elements on factor diagonal */
+	if ((temp=*tp)<0.0) {
+	  *tp=-temp; *cval=-(*cval); *sval=-(*sval);
+	  CHOL_INSTR_FLIP(CHOL_KUP);
+	} else if (temp==0.0) {
+	  retcode=CHOL_NUMERR; break;
+	}
+	if (sz>0)
+	  BLASFUNC(drot) (&sz,tp+1,&ione,wkvec+(j*n+i+1),&ione,cval,sval);
+      }
+    }
+    if (retcode!=CHOL_OK) break;
+    /* Apply all rotations of tile column to each tile below */
+    for (ti=tj+1; ti<nt; ti++) {
+      i0=ti*nb; mi=(i0+nb<n)?nb:(n-i0);
+      tile=cholTilePtr(tbuff,n,nb,ti,tj);
+      for (c=0; c<mj; c++)
+	for (j=0; j<k; j++)
+	  BLASFUNC(drot) (&mi,tile+(c*nb),&ione,wkvec+(j*n+i0),&ione,
+			  cvec+(j*n+j0+c),svec+(j*n+j0+c));
+    }
+  }
+  /* As in 'cholUpRkK', generation and application of rotations are
+     timed together as CHOL_PSWEEP */
+  CHOL_INSTR_LAP(CHOL_KUP,CHOL_PSWEEP);
+  if (retcode!=CHOL_OK) {
+    CHOL_INSTR_FAIL(CHOL_KUP);
+    return retcode;
+  }
+  CHOL_INSTR_WORK(CHOL_KUP,3.0*k*n*(n-1),16.0*k*n*(n-1));
+
+  /* Dragging along */
+  if (r>0) {
+    cholUpDrag(n,k,cvec,svec,wkvec,zbuff,r,ldz,incz,ymat);
+    CHOL_INSTR_LAP(CHOL_KUP,CHOL_PDRAG);
+    CHOL_INSTR_WORK(CHOL_KUP,6.0*k*n*r,32.0*k*n*r);
+  }
+
+  return CHOL_OK;
+}
+
+/*
+ * Rank one update on tiled L, see 'cholUpRk1'
+ */
+int cholTileUpRk1(double* tbuff,int n,int nb,const double* vvec,
+		  double* cvec,double* svec,double* wkvec,double* zbuff,
+		  int r,int ldz,int incz,const double* yvec)
+{
+  return cholTileUpRkK(tbuff,n,nb,1,vvec,cvec,svec,wkvec,zbuff,r,ldz,incz,
+		       yvec);
+}
+
+/*
+ * Rank one downdate on tiled L, see 'cholDnRk1'
+ * The sweep runs over tile rows. Within tile row I, the rotations are
+ * applied from the diagonal tile to the left, which keeps their order
+ * (n-1 down to 0) for each row of L.
+ */
+int cholTileDnRk1(double* tbuff,int n,int nb,const double* vvec,int isp,
+		  double* cvec,double* svec,double* wkvec,double* zbuff,
+		  int r,int ldz,int incz,const double* yvec)
+{
+  int i,c,ti,tj,nt,i0,j0,mi,mj,sz,ione=1,retcode=CHOL_OK;
+  double qs,one=1.0,mone=-1.0;
+  double* tile,*tp;
+  int* flip=0;
+  CHOL_INSTR_DECL
+
+  CHOL_INSTR_CALL(CHOL_KDN,n);
+  CHOL_INSTR_START;
+  nt=(n+nb-1)/nb;
+  /* Compute p (if not given), by blocked forward substitution */
+  BLASFUNC(dcopy) (&n,vvec,&ione,wkvec,&ione);
+  if (!isp) {
+    for (tj=0; tj<nt; tj++) {
+      j0=tj*nb; mj=(j0+nb<n)?nb:(n-j0);
+      BLASFUNC(dtrsv) ("L","N","N",&mj,cholTilePtr(tbuff,n,nb,tj,tj),&nb,
+		       wkvec+j0,&ione);
+      for (ti=tj+1; ti<nt; ti++) {
+	i0=ti*nb; mi=(i0+nb<n)?nb:(n-i0);
+	BLASFUNC(dgemv) ("N",&mi,&mj,&mone,cholTilePtr(tbuff,n,nb,ti,tj),&nb,
+			 wkvec+j0,&ione,&one,wkvec+i0,&ione);
+      }
+    }
+    CHOL_INSTR_LAP(CHOL_KDN,CHOL_PSOLVE);
+    CHOL_INSTR_WORK(CHOL_KDN,1.0*n*n,4.0*n*(n+1)+16.0*n);
+  }
+  /* Generate Givens rotations */
+  qs=1.0-BLASFUNC(ddot) (&n,wkvec,&ione,wkvec,&ione);
+  if (qs<=0.0) {
+    CHOL_INSTR_FAIL(CHOL_KDN);
+    return CHOL_NOTPD;
+  }
+  qs=sqrt(qs);
+  for (i=n-1; i>=0; i--) {
+    BLASFUNC(drotg) (&qs,wkvec+i,cvec+i,svec+i);
+    /* 'qs' must remain positive */
+    if (qs<0.0) {
+      qs=-qs; cvec[i]=-cvec[i]; svec[i]=-svec[i];
+    }
+  }
+  CHOL_INSTR_LAP(CHOL_KDN,CHOL_PROTG);
+
+  /* Update L. If there are any flips of L_ cols, we alloc. 'flip' and
+     mark them there */
+  for (i=0; i<n; i++) wkvec[i]=0.0;
+  for (ti=0; ti<nt && retcode==CHOL_OK; ti++) {
+    i0=ti*nb; mi=(i0+nb<n)?nb:(n-i0);
+    /* Diagonal tile. Decides about flips */
+    tile=cholTilePtr(tbuff,n,nb,ti,ti);
+    for (c=mi-1; c>=0; c--) {
+      i=i0+c; tp=tile+(c*(nb+1)); sz=mi-c;
+      if (*tp<=0.0) {
+	retcode=CHOL_NUMERR; break;
+      }
+      BLASFUNC(drot) (&sz,wkvec+i,&ione,tp,&ione,cvec+i,svec+i);
+      /* Do not want negative elements on diagonal */
+      if (*tp<0.0) {
+	if (flip==0 && (flip=(int*) calloc(n,sizeof(int)))==0) {
+	  /* Does this ever happen? Out of memory: L_ is undefined */
+	  retcode=CHOL_NUMERR; break;
+	}
+	flip[i]=1;
+	CHOL_INSTR_FLIP(CHOL_KDN);
+	BLASFUNC(dscal) (&sz,&mone,tp,&ione);
+      } else if (*tp==0.0) {
+	retcode=CHOL_NUMERR; break;
+      }
+    }
+    /* Tiles to the left */
+    for (tj=ti-1; tj>=0 && retcode==CHOL_OK; tj--) {
+      j0=tj*nb;
+      tile=cholTilePtr(tbuff,n,nb,ti,tj);
+      for (c=nb-1; c>=0; c--) {
+	i=j0+c;
+	BLASFUNC(drot) (&mi,wkvec+i0,&ione,tile+(c*nb),&ione,cvec+i,svec+i);
+	if (flip!=0 && flip[i]!=0)
+	  BLASFUNC(dscal) (&mi,&mone,tile+(c*nb),&ione);
+      }
+    }
+  }
+  CHOL_INSTR_LAP(CHOL_KDN,CHOL_PSWEEP);
+  CHOL_INSTR_WORK(CHOL_KDN,3.0*n*(n+1),16.0*n*(n+1));
+
+  /* Dragging along */
+  if (r>0 && retcode==CHOL_OK) {
+    cholDnDrag(n,cvec,svec,flip,wkvec,zbuff,r,ldz,incz,yvec);
+    CHOL_INSTR_LAP(CHOL_KDN,CHOL_PDRAG);
+    CHOL_INSTR_WORK(CHOL_KDN,6.0*n*r,80.0*n*r);
+  }
+  if (flip!=0) free((void*) flip);
+  if (retcode!=CHOL_OK)
+    CHOL_INSTR_FAIL(CHOL_KDN);
+
+  return retcode;
+}
+
+/*
+ * Exchange update on tiled L = R', see 'cholUpExch'
+ * Rows of R are columns of L, so that all rotations act on pairs of
+ * contiguous column segments. Compared to DCHEX, the loops over
+ * rotations and columns of R are interchanged, which does not change
+ * the order in which rotations are applied to any single column of R.
+ * CVEC, SVEC need size n.
+ */
+int cholTileUpExch(double* tbuff,int n,int nb,int k,int l,int job,
+		   double* xbuff,int ldx,int incx,int nz,double* zbuff,int r,
+		   int ldz,int incz,double* cvec,double* svec)
+{
+  int i,j,c,a,km1,lm1,lmk;
+  double t;
+  CHOL_INSTR_DECL
+
+  CHOL_INSTR_CALL(CHOL_KEXCH,n);
+  CHOL_INSTR_START;
+  /* 0-based: K=k-1, L=l-1 */
+  km1=k-1; lm1=l-1; lmk=l-k;
+  if (job==1) {
+    /* Right circular shift. Reorder columns of R (rows of L) */
+    for (i=0; i<=lm1; i++)
+      svec[i]=*cholTileElem(tbuff,n,nb,lm1,lm1-i);
+    for (c=0; c<lm1; c++)
+      cholTileShiftCol(tbuff,n,nb,c,(km1>c)?km1:c,lm1,1);
+    for (j=km1; j<lm1; j++)
+      *cholTileElem(tbuff,n,nb,j+1,j+1)=0.0;
+    for (c=0; c<km1; c++)
+      *cholTileElem(tbuff,n,nb,km1,c)=svec[lm1-c];
+    /* Calculate the rotations */
+    t=svec[0];
+    for (i=0; i<lmk; i++) {
+      BLASFUNC(drotg) (svec+(i+1),&t,cvec+i,svec+i);
+      t=svec[i+1];
+    }
+    *cholTileElem(tbuff,n,nb,km1,km1)=t;
+    /* U(i+1) acts in plane (a,a+1), a=L-1-i */
+    for (i=0; i<lmk; i++) {
+      a=lm1-1-i;
+      cholTileRotCols(tbuff,n,nb,a+1,a,a+1,cvec+i,svec+i);
+    }
+  } else {
+    /* Left circular shift. Reorder columns of R (rows of L) */
+    for (c=0; c<=km1; c++)
+      svec[lmk+c]=*cholTileElem(tbuff,n,nb,km1,c);
+    for (j=km1; j<lm1; j++)
+      svec[j-km1]=*cholTileElem(tbuff,n,nb,j+1,j+1);
+    for (c=0; c<lm1; c++)
+      cholTileShiftCol(tbuff,n,nb,c,((km1>c)?km1:c)+1,l,0);
+    for (c=0; c<=km1; c++)
+      *cholTileElem(tbuff,n,nb,lm1,c)=svec[lmk+c];
+    for (c=k; c<=lm1; c++)
+      *cholTileElem(tbuff,n,nb,lm1,c)=0.0;
+    /* Reduction loop. U(i+1) acts in plane (a,a+1), a=K+i */
+    for (i=0; i<lmk; i++) {
+      a=km1+i;
+      t=svec[i];
+      BLASFUNC(drotg) (cholTileElem(tbuff,n,nb,a,a),&t,cvec+i,svec+i);
+      cholTileRotCols(tbuff,n,nb,a+1,a,a+1,cvec+i,svec+i);
+    }
+  }
+  /* Apply the rotations to X */
+  for (i=0; i<lmk && nz>0; i++) {
+    a=(job==1)?(lm1-1-i):(km1+i);
+    BLASFUNC(drot) (&nz,xbuff+(a*incx),&ldx,xbuff+((a+1)*incx),&ldx,
+		    cvec+i,svec+i);
+  }
+  CHOL_INSTR_LAP(CHOL_KEXCH,CHOL_PSWEEP);
+  CHOL_INSTR_WORK(CHOL_KEXCH,3.0*lmk*(2*n-2*l+lmk+1)+6.0*lmk*nz,
+		  16.0*lmk*(2*n-2*l+lmk+1)+32.0*lmk*nz);
+  if (r>0)
+    for (i=0; i<lmk; i++) {
+      a=(job==1)?(lm1-1-i):(km1+i);
+      BLASFUNC(drot) (&r,zbuff+(a*ldz),&incz,zbuff+((a+1)*ldz),&incz,
+		      cvec+i,svec+i);
+    }
+  /* Same workaround as in 'cholUpExch': R(j,j) < 0 for some
+     k<=j<=l, the corr. row of R (column of L) is multiplied by -1 */
+  for (j=km1; j<=lm1; j++)
+    if (*cholTileElem(tbuff,n,nb,j,j)<0.0) {
+      cholTileScalCol(tbuff,n,nb,j,j,-1.0);
+      t=-1.0;
+      if (nz!=0)
+	BLASFUNC(dscal) (&nz,&t,xbuff+(j*incx),&ldx);
+      if (r>0)
+	BLASFUNC(dscal) (&r,&t,zbuff+(j*ldz),&incz);
+      CHOL_INSTR_FLIP(CHOL_KEXCH);
+    }
+  /* Also adds the flips of the workaround */
+  CHOL_INSTR_LAP(CHOL_KEXCH,CHOL_PDRAG);
+  if (r>0)
+    CHOL_INSTR_WORK(CHOL_KEXCH,6.0*lmk*r,32.0*lmk*r);
+
+  return CHOL_OK;
+}
+
+#ifdef MEX_HELPER_H
+/*
+ * Tiled factor argument for MEX functions. A tiled factor is passed as
+ * cell vector { TBUFF, [N NB] }, where TBUFF is the buffer created by
+ * CHOLTILE. Returns false if 'arg' is not of this form (then, it must
+ * be a normal factor, see 'parseBLASMatrix').
+ */
+typedef struct {
+  double* buff;
+  int n,nb;
+} tiled_matrix;
+
+bool parseTiledMatrix(const mxArray* arg,const char* name,tiled_matrix* mat)
+{
+  const mxArray* szvec;
+  const double* iP;
+  int i;
+
+  if (!mxIsCell(arg) || mxGetM(arg)*mxGetN(arg)!=2)
+    return false;
+  szvec=mxGetCell(arg,1);
+  if (!mxIsDouble(szvec) || mxGetM(szvec)*mxGetN(szvec)!=2)
+    return false;
+  iP=mxGetPr(szvec);
+  /* Same integer check as 'getScalInt' (also catches NaN) */
+  for (i=0; i<2; i++)
+    if (floor(iP[i])!=iP[i] || iP[i]<1.0 || iP[i]>(double) INT_MAX) {
+      sprintf(errMsg,"Size vector in %s wrong (expect positive integers)",
+	      name);
+      mexErrMsgTxt(errMsg);
+    }
+  mat->n=(int) iP[0]; mat->nb=(int) iP[1];
+  if ((size_t) getVecLen(mxGetCell(arg,0),name)!=
+      cholTileSize(mat->n,mat->nb)) {
+    sprintf(errMsg,"Tiled buffer in %s has wrong size",name);
+    mexErrMsgTxt(errMsg);
+  }
+  mat->buff=mxGetPr(mxGetCell(arg,0));
+
+  return true;
+}
+#endif
+
+#endif
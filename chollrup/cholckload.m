@@ -0,0 +1,38 @@
+function [lfact,z,nrec,uplo]=cholckload(fname)
+%CHOLCKLOAD Read checkpoint written by CHOLSTREAM
+%  [LFACT,Z,NREC,UPLO]=CHOLCKLOAD(FNAME)
+%
+%  Reads the checkpoint file FNAME written by CHOLSTREAM. LFACT is the
+%  n-by-n factor, UPLO its triangle ('L' or 'U'), Z the r-by-n drag
+%  along matrix ([] if r==0). NREC is the number of records applied,
+%  to be passed as NSKIP to CHOLSTREAM when restarting on the same
+%  stream:
+%    [lfact,z,nrec,uplo]=cholckload(ckfname);
+%    cholstream({lfact,[1 1 n n],[uplo ' ']},fname,z,kmax,ckfname, ...
+%               ckfreq,logfname,nrec);
+
+fid=fopen(fname,'r');
+if fid==-1
+  error(sprintf('Cannot open checkpoint %s',fname));
+end
+head=fread(fid,4,'double');
+if length(head)~=4
+  fclose(fid);
+  error('Checkpoint file corrupted');
+end
+n=head(1); r=head(2); nrec=head(4);
+if head(3)~=0
+  uplo='L';
+else
+  uplo='U';
+end
+lfact=fread(fid,[n n],'double');
+z=[];
+if r>0
+  z=fread(fid,[r n],'double');
+end
+fclose(fid);
+if size(lfact,1)~=n || size(lfact,2)~=n || size(z,1)~=r || ...
+   (r>0 && size(z,2)~=n)
+  error('Checkpoint file corrupted');
+end
@@ -38,7 +38,7 @@
  *
  * Input:
  * - L:     Factor L (or L'), overwritten by L_ (or L_'). Must be
- *          lower (upper) triangular, str. code UPLO
+ *          lower (upper) triangular, str. code UPLO. Or tiled factor
  * - VEC:   Vector v. Can have size >n, only first n elem. are used
  * - CVEC:  Vector [n]. c_k ret. here
  * - SVEC:  Vector [n]. s_k ret. here
@@ -49,6 +49,17 @@
  *
  * Return:
  * - STAT:  0 (OK), 1 (Numerical error)
+ *
+ * Tiled factor:
+ * L can also be a tiled factor { TBUFF, [n NB] } created by CHOLTILE
+ * (always holds L, not L'). For large n, this is faster than passing
+ * L' (upper triangular). See chol_tiled.h.
+ *
+ * Instrumentation:
+ * If compiled with -DCHOL_INSTRUMENT (make MEXFLAGS=-DCHOL_INSTRUMENT),
+ * the kernels maintain hot-path counters. CHOLDNRK1('stats') returns them,
+ * CHOLDNRK1('reset') resets them, CHOLDNRK1('dump') prints them. See
+ * chol_instr.h for details.
  * -------------------------------------------------------------------
  * Matlab MEX Function
  * Author: Matthias Seeger
@@ -57,51 +68,47 @@
 #include <math.h>
 #include "mex.h"
 #include "mex_helper.h"
-#include "blas_headers.h"
+#include "chol_tiled.h"
 
 char errMsg[200];
 
 /*
- * The method is adapted from LINPACK dchdd. We did the following
- * modifications:
- * - Using BLAS drot in order to avoid any explicit O(n^2) loops
- * - Keeping diag(L_) positive, by flipping columns of L_ whenever a
- *   negative element pops up
- * See the TR
- *   M. Seeger
- *   Low Rank Updates for the Cholesky Decomposition
- *   Available at: www.kyb.tuebingen.mpg.de/bs/people/seeger/papers/
+ * The method is implemented in 'cholDnRk1', see chol_kernels.h.
  */
 
 /* Main function CHOLDNRK1 */
 
 void mexFunction(int nlhs,mxArray *plhs[],int nrhs,const mxArray *prhs[])
 {
-  int i,n,r=0,stp,sz,ione=1,retcode=0,nxi,npos;
-  double qs,cval,sval,c1,c2;
+  int i,n,r=0,retcode;
   fst_matrix lmat,zmat;
+  tiled_matrix tmat;
   const double* vvec;
-  double* cvec,*svec,*wkvec,*yvec;
-  bool islower,isp=false;
-  double* tbuff,*zcol;
-  const char* diag="N";
-  char trans[2];
-  int* flind=0;
+  double* cvec,*svec,*wkvec,*yvec=0;
+  bool istiled,islower,isp=false;
+
+  /* Instrumentation commands */
+  if (cholInstrMexCmd(nlhs,plhs,nrhs,prhs))
+    return;
 
   /* Read arguments */
   if (nrhs<5)
     mexErrMsgTxt("Not enough input arguments");
   if (nlhs>1)
     mexErrMsgTxt("Too many return arguments");
-  parseBLASMatrix(prhs[0],"L",&lmat,-1,-1);
-  if ((n=lmat.n)!=lmat.m ||
-      (!(islower=(UPLO(lmat.strcode)=='L')) && UPLO(lmat.strcode)!='U'))
-    mexErrMsgTxt("L must be lower/upper triangular (use UPLO str. code!)");
+  if (!(istiled=parseTiledMatrix(prhs[0],"L",&tmat))) {
+    parseBLASMatrix(prhs[0],"L",&lmat,-1,-1);
+    if ((n=lmat.n)!=lmat.m ||
+	(!(islower=(UPLO(lmat.strcode)=='L')) && UPLO(lmat.strcode)!='U'))
+      mexErrMsgTxt("L must be lower/upper triangular (use UPLO str. code!)");
+  } else
+    n=tmat.n;
   if (getVecLen(prhs[1],"VEC")<n) mexErrMsgTxt("VEC too short");
   vvec=mxGetPr(prhs[1]);
   if (getVecLen(prhs[2],"CVEC")!=n || getVecLen(prhs[3],"SVEC")!=n)
     mexErrMsgTxt("CVEC, SVEC have wrong size");
   cvec=mxGetPr(prhs[2]); svec=mxGetPr(prhs[3]);
+  zmat.buff=0; zmat.stride=1;
   if (nrhs>5) {
     isp=(getScalInt(prhs[5],"ISP")!=0);
     if (nrhs>6) {
@@ -116,85 +123,16 @@ void mexFunction(int nlhs,mxArray *plhs[],int nrhs,const mxArray *prhs[])
   if (i<n || i<r) mexErrMsgTxt("WORKV too short");
   wkvec=mxGetPr(prhs[4]);
 
-  /* Compute p (if not given) */
-  BLASFUNC(dcopy) (&n,vvec,&ione,wkvec,&ione);
-  if (!isp) {
-    trans[1]=0;
-    trans[0]=islower?'N':'T';
-    BLASFUNC(dtrsv) (&UPLO(lmat.strcode),trans,diag,&n,lmat.buff,&lmat.stride,
-		     wkvec,&ione);
-  }
-  /* Generate Givens rotations */
-  qs=1.0-BLASFUNC(ddot) (&n,wkvec,&ione,wkvec,&ione);
-  if (qs<=0.0)
-    retcode=1;
-  else {
-    qs=sqrt(qs);
-    for (i=n-1; i>=0; i--) {
-      BLASFUNC(drotg) (&qs,wkvec+i,cvec+i,svec+i);
-      /* 'qs' must remain positive */
-      if (qs<0.0) {
-	qs=-qs; cvec[i]=-cvec[i]; svec[i]=-svec[i];
-      }
-    }
-    /* NOTE: 'qs' should be 1 now */
-
-    /* Update L. If there are any flips of L_ cols, we alloc. 'flind' are
-       store their pos. there */
-    fillVec(wkvec,n,0.0);
-    stp=islower?1:lmat.stride;
-    for (i=n-1,sz=0,tbuff=lmat.buff+((n-1)*(lmat.stride+1)); i>=0; i--) {
-      /* BAD: Slower for upper triangular! */
-      sz++;
-      if (*tbuff<=0.0) {
-	retcode=1; break;
-      }
-      BLASFUNC(drot) (&sz,wkvec+i,&ione,tbuff,&stp,cvec+i,svec+i);
-      /* Do not want negative elements on diagonal */
-      if (*tbuff<0.0) {
-	if (flind==0) {
-	  /* Does this ever happen?
-	     Allocate 'flind'. Size n, to make sure. Grows from the right */
-	  flind=(int*) mxMalloc(n*sizeof(int));
-	  npos=n;
-	}
-	flind[--npos]=i;
-	qs=-1.0;
-	BLASFUNC(dscal) (&sz,&qs,tbuff,&stp);
-      } else if (*tbuff==0.0) {
-	retcode=1; break;
-      }
-      tbuff-=(lmat.stride+1);
-    }
-    /* NOTE: Should have v in 'wkvec' now */
-
-    /* Dragging along */
-    if (r>0 && retcode==0) {
-      BLASFUNC(dcopy) (&r,yvec,&ione,wkvec,&ione);
-      nxi=(flind!=0)?flind[npos]:-1;
-      for (i=0; i<n; i++) {
-	zcol=zmat.buff+(i*zmat.stride);
-	cval=cvec[i]; sval=svec[i];
-	qs=-sval;
-	BLASFUNC(daxpy) (&r,&qs,wkvec,&ione,zcol,&ione);
-	if (nxi==i) {
-	  if (++npos<n) nxi=flind[npos];
-	  c1=-1.0/cval; c2=sval;
-	} else {
-	  c1=1.0/cval; c2=-sval;
-	}
-	BLASFUNC(dscal) (&r,&c1,zcol,&ione);
-	if (i<n-1) {
-	  BLASFUNC(dscal) (&r,&cval,wkvec,&ione);
-	  BLASFUNC(daxpy) (&r,&c2,zcol,&ione,wkvec,&ione);
-	}
-      }
-    }
-  }
+  /* Update L, drag along Z */
+  if (istiled)
+    retcode=cholTileDnRk1(tmat.buff,n,tmat.nb,vvec,isp,cvec,svec,wkvec,
+			  zmat.buff,r,zmat.stride,1,yvec);
+  else
+    retcode=cholDnRk1(lmat.buff,n,lmat.stride,islower,vvec,isp,cvec,svec,
+		      wkvec,zmat.buff,r,zmat.stride,1,yvec);
 
-  if (flind!=0) mxFree((void*) flind);
   if (nlhs==1) {
     plhs[0]=mxCreateDoubleMatrix(1,1,mxREAL);
-    *(mxGetPr(plhs[0]))=(double) retcode;
+    *(mxGetPr(plhs[0]))=(retcode==CHOL_OK)?0.0:1.0;
   }
 }
@@ -35,3 +35,14 @@
 %  the corr. column of L_ is flipped. In the present implementation, this
 %  is not reported back, so the change L -> L' cannot always be
 %  reconstructed from CVEC, SVEC alone.
+%
+%  Tiled factor:
+%  L can also be a tiled factor { TBUFF, [n NB] } created by CHOLTILE
+%  (always holds L, not L'). For large n, this is faster than passing
+%  L' (upper triangular). See chol_tiled.h.
+%
+%  Instrumentation:
+%  If compiled with -DCHOL_INSTRUMENT (make MEXFLAGS=-DCHOL_INSTRUMENT),
+%  the kernels maintain hot-path counters. CHOLDNRK1('stats') returns them,
+%  CHOLDNRK1('reset') resets them, CHOLDNRK1('dump') prints them. See
+%  chol_instr.h for details.
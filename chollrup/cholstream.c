@@ -0,0 +1,383 @@
+/* -------------------------------------------------------------------
+ * CHOLSTREAM
+ *
+ * ATTENTION: We use the undocumented fact that the content of
+ * matrices passed as arguments to a MEX function can be overwritten
+ * like in a proper call-by-reference. This is not officially
+ * supported and may not work in future Matlab versions!
+ *
+ * Applies a stream of update, downdate and exchange records to the
+ * Cholesky factor L (lower or upper triangular, str. code UPLO, or
+ * tiled factor, see CHOLUPRK1), dragging along Z (r-by-n) if given. The
+ * stream is read from the file FNAME, which can also be a named pipe.
+ * This replaces one CHOLUPRK1, CHOLDNRK1 or CHOLUPEXCH call per record.
+ *
+ * Record format:
+ * All entries are doubles in native byte order. A record starts with
+ * its type, followed by the payload:
+ * - 1 (update):   v [n], y [r]. A_ = A + v*v', Z_ L_' = Z L' + y v'
+ * - 2 (downdate): v [n], y [r]. A_ = A - v*v', Z_ L_' = Z L' - y v'
+ * - 3 (exchange): K, L, JOB. A_ = E' A E, see CHOLUPEXCH. Z is
+ *                 replaced by Z_ = Z U', so that Z_ L_' = Z L' E
+ * Runs of consecutive updates are grouped into rank-k updates with
+ * k <= KMAX, which sweep over L only once (see 'cholUpRkK').
+ *
+ * Rejected records:
+ * A downdate which would render A_ not positive definite, and an
+ * exchange with invalid K, L, JOB are rejected. L, Z are not modified,
+ * and the stream continues. If LOGFNAME is given, a line is appended to
+ * this file for each rejected record. A numerical error in the update
+ * sweep leaves L, Z undefined and stops the stream (STAT = 1). It is
+ * logged as well, naming the failing record (or the range of records of
+ * a grouped rank-k update).
+ *
+ * Checkpointing:
+ * If CKFNAME is given, L and Z are written to this file after every
+ * CKFREQ records (0: only at the end of the stream). The file is
+ * written under CKFNAME.tmp first and then renamed, so CKFNAME always
+ * contains a complete checkpoint. Format (doubles): [n r islower nrec],
+ * followed by L (n-by-n, both triangles as stored) and Z (r-by-n),
+ * column by column. A tiled factor is written as lower triangular L,
+ * with zeros above the diagonal. Use CHOLCKLOAD to read it. To restart
+ * after a crash, pass the factor and Z from the checkpoint, together
+ * with NSKIP = nrec, so that the records already applied are skipped.
+ *
+ * Input:
+ * - L:        Factor L (or L'), overwritten. Must be lower (upper)
+ *             triangular, str. code UPLO. Or tiled factor
+ * - FNAME:    Record stream file name
+ * - Z:        Dragging along matrix [r-by-n]. Optional [def: []]
+ * - KMAX:     Max. rank of grouped updates [def: 32]
+ * - CKFNAME:  Checkpoint file name [def: '', no checkpoints]
+ * - CKFREQ:   Checkpoint frequency (records) [def: 0]
+ * - LOGFNAME: Log file name for rejected records and numerical errors
+ *             [def: '', no log]
+ * - NSKIP:    Number of records to skip at the start [def: 0]
+ *
+ * Return:
+ * - STAT:     0 (OK), 1 (Numerical error), 2 (Stream corrupted)
+ * - NREC:     Number of records applied (or rejected), including NSKIP.
+ *             Records of a failing update (STAT = 1) are not counted, so
+ *             NREC+1 is the first record not applied
+ * - NREJ:     Number of rejected records
+ *
+ * Instrumentation:
+ * If compiled with -DCHOL_INSTRUMENT (make MEXFLAGS=-DCHOL_INSTRUMENT),
+ * the kernels maintain hot-path counters. CHOLSTREAM('stats') returns them,
+ * CHOLSTREAM('reset') resets them, CHOLSTREAM('dump') prints them. See
+ * chol_instr.h for details.
+ * -------------------------------------------------------------------
+ * Matlab MEX Function
+ * Author: Matthias Seeger
+ * ------------------------------------------------------------------- */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "mex.h"
+#include "mex_helper.h"
+#include "chol_tiled.h"
+
+char errMsg[200];
+
+/* Record types */
+#define REC_UPDATE   1
+#define REC_DOWNDATE 2
+#define REC_EXCHANGE 3
+
+/*
+ * Reads the type of the next record. Returns 0 at the end of the
+ * stream, -1 if the type is not valid or the stream ends within it.
+ */
+int readRecType(FILE* fp)
+{
+  double val;
+  size_t nread;
+
+  if ((nread=fread(&val,1,sizeof(double),fp))==0)
+    return 0;
+  if (nread!=sizeof(double) ||
+      (val!=REC_UPDATE && val!=REC_DOWNDATE && val!=REC_EXCHANGE))
+    return -1;
+  return (int) val;
+}
+
+/*
+ * Reads 'cnt' doubles into 'buff'. Returns false if the stream ends
+ * before.
+ */
+bool readDoubles(FILE* fp,double* buff,int cnt)
+{
+  return (cnt==0 || fread(buff,sizeof(double),cnt,fp)==(size_t) cnt);
+}
+
+/*
+ * Applies batch of 'nbatch' updates (see 'cholUpRkK'). L is tiled iff
+ * tmat->buff!=0.
+ */
+int updateBatch(const fst_matrix* lmat,const tiled_matrix* tmat,
+		bool islower,int nbatch,const double* vbuff,double* cvec,
+		double* svec,double* wkvec,const fst_matrix* zmat,int r,
+		const double* ybuff)
+{
+  if (tmat->buff!=0)
+    return cholTileUpRkK(tmat->buff,tmat->n,tmat->nb,nbatch,vbuff,cvec,svec,
+			 wkvec,zmat->buff,r,zmat->stride,1,ybuff);
+  else
+    return cholUpRkK(lmat->buff,lmat->n,lmat->stride,islower,nbatch,vbuff,
+		     cvec,svec,wkvec,zmat->buff,r,zmat->stride,1,ybuff);
+}
+
+/*
+ * Numerical error in the records nrec-cnt+1, ..., nrec (single record,
+ * or batch of updates). Appends a line to the log file (if 'logfp'!=0)
+ * and returns the number of records applied before.
+ */
+int logNumErr(FILE* logfp,int nrec,int cnt)
+{
+  if (logfp!=0) {
+    if (cnt==1)
+      fprintf(logfp,"Record %d: numerical error, stream stopped\n",nrec);
+    else
+      fprintf(logfp,"Records %d-%d: numerical error in rank-%d update, "
+	      "stream stopped\n",nrec-cnt+1,nrec,cnt);
+  }
+  return nrec-cnt;
+}
+
+/*
+ * Writes checkpoint (see header comment) to 'fname'. Returns false on
+ * I/O error. L is tiled iff tmat->buff!=0, then 'colbuff' (size n) is
+ * used to gather the columns.
+ */
+bool writeCheckpoint(const char* fname,const fst_matrix* lmat,
+		     const tiled_matrix* tmat,bool islower,
+		     const fst_matrix* zmat,int r,int nrec,double* colbuff)
+{
+  int i,n=(tmat->buff!=0)?tmat->n:lmat->n;
+  double head[4];
+  char* tmpname;
+  FILE* fp;
+  bool ok;
+
+  tmpname=(char*) mxMalloc((strlen(fname)+5)*sizeof(char));
+  sprintf(tmpname,"%s.tmp",fname);
+  if ((fp=fopen(tmpname,"wb"))==0) {
+    mxFree((void*) tmpname);
+    return false;
+  }
+  head[0]=(double) n; head[1]=(double) r;
+  head[2]=islower?1.0:0.0; head[3]=(double) nrec;
+  ok=(fwrite(head,sizeof(double),4,fp)==4);
+  for (i=0; i<n && ok; i++)
+    if (tmat->buff!=0) {
+      cholTileGetCol(tmat->buff,n,tmat->nb,i,colbuff);
+      ok=(fwrite(colbuff,sizeof(double),n,fp)==(size_t) n);
+    } else
+      ok=(fwrite(lmat->buff+(i*lmat->stride),sizeof(double),n,fp)==
+	  (size_t) n);
+  for (i=0; i<n && r>0 && ok; i++)
+    ok=(fwrite(zmat->buff+(i*zmat->stride),sizeof(double),r,fp)==
+	(size_t) r);
+  ok=(fclose(fp)==0 && ok);
+  if (ok)
+    ok=(rename(tmpname,fname)==0);
+  else
+    remove(tmpname);
+  mxFree((void*) tmpname);
+
+  return ok;
+}
+
+/* Main function CHOLSTREAM */
+
+void mexFunction(int nlhs,mxArray *plhs[],int nrhs,const mxArray *prhs[])
+{
+  int n,r=0,kmax=32,ckfreq=0,nskip=0,nrec=0,nrej=0,nbatch=0,sz;
+  int type,k,l,job,retcode=CHOL_OK,stat=0;
+  fst_matrix lmat,zmat;
+  tiled_matrix tmat;
+  bool islower=true;
+  const char* fname,*ckfname=0,*logfname=0,*reason;
+  double* cvec,*svec,*wkvec,*vbuff,*ybuff,*recbuff;
+  FILE* fp,*logfp=0;
+
+  /* Instrumentation commands */
+  if (cholInstrMexCmd(nlhs,plhs,nrhs,prhs))
+    return;
+
+  /* Read arguments */
+  if (nrhs<2)
+    mexErrMsgTxt("Not enough input arguments");
+  if (nlhs>3)
+    mexErrMsgTxt("Too many return arguments");
+  if (!parseTiledMatrix(prhs[0],"L",&tmat)) {
+    tmat.buff=0;
+    parseBLASMatrix(prhs[0],"L",&lmat,-1,-1);
+    if ((n=lmat.n)!=lmat.m ||
+	(!(islower=(UPLO(lmat.strcode)=='L')) && UPLO(lmat.strcode)!='U'))
+      mexErrMsgTxt("L must be lower/upper triangular (use UPLO str. code!)");
+  } else
+    n=tmat.n;
+  zmat.buff=0; zmat.stride=1;
+  if (nrhs>2 && !mxIsEmpty(prhs[2])) {
+    parseBLASMatrix(prhs[2],"Z",&zmat,-1,n);
+    r=zmat.m;
+  }
+  if (nrhs>3 && (kmax=getScalInt(prhs[3],"KMAX"))<1)
+    mexErrMsgTxt("KMAX must be positive");
+  if (nrhs>4 && !mxIsEmpty(prhs[4]))
+    ckfname=getString(prhs[4],"CKFNAME");
+  if (nrhs>5 && (ckfreq=getScalInt(prhs[5],"CKFREQ"))<0)
+    mexErrMsgTxt("CKFREQ must be nonnegative");
+  if (nrhs>6 && !mxIsEmpty(prhs[6]))
+    logfname=getString(prhs[6],"LOGFNAME");
+  if (nrhs>7 && (nskip=getScalInt(prhs[7],"NSKIP"))<0)
+    mexErrMsgTxt("NSKIP must be nonnegative");
+  fname=getString(prhs[1],"FNAME");
+  sz=(n>r)?n:r;
+  cvec=(double*) mxMalloc(n*kmax*sizeof(double));
+  svec=(double*) mxMalloc(n*kmax*sizeof(double));
+  wkvec=(double*) mxMalloc(sz*kmax*sizeof(double));
+  vbuff=(double*) mxMalloc(n*kmax*sizeof(double));
+  ybuff=(double*) mxMalloc((r*kmax+1)*sizeof(double));
+  /* Also used as column buffer in 'writeCheckpoint' */
+  recbuff=(double*) mxMalloc((n+r+3)*sizeof(double));
+  if ((fp=fopen(fname,"rb"))==0) {
+    sprintf(errMsg,"Cannot open stream %.150s",fname);
+    mexErrMsgTxt(errMsg);
+  }
+  if (logfname!=0 && (logfp=fopen(logfname,"a"))==0) {
+    fclose(fp);
+    sprintf(errMsg,"Cannot open log file %.150s",logfname);
+    mexErrMsgTxt(errMsg);
+  }
+
+  /* Main loop */
+  while (stat==0) {
+    if ((type=readRecType(fp))==0) break;
+    if (type<0) {
+      stat=2; break;
+    }
+    sz=(type==REC_EXCHANGE)?3:(n+r);
+    if (nrec<nskip) {
+      /* Record applied before checkpoint was written */
+      if (!readDoubles(fp,recbuff,sz)) stat=2;
+      else nrec++;
+      continue;
+    }
+    if (type==REC_UPDATE) {
+      /* Append to batch */
+      if (!readDoubles(fp,vbuff+(nbatch*n),n) ||
+	  !readDoubles(fp,ybuff+(nbatch*r),r)) {
+	stat=2; break;
+      }
+      nrec++;
+      if (++nbatch==kmax) {
+	if (updateBatch(&lmat,&tmat,islower,nbatch,vbuff,cvec,svec,wkvec,
+			&zmat,r,ybuff)!=CHOL_OK) {
+	  nrec=logNumErr(logfp,nrec,nbatch); stat=1; break;
+	}
+	nbatch=0;
+      }
+    } else {
+      if (!readDoubles(fp,recbuff,sz)) {
+	stat=2; break;
+      }
+      /* Pending updates have to be applied first */
+      if (nbatch>0) {
+	if (updateBatch(&lmat,&tmat,islower,nbatch,vbuff,cvec,svec,wkvec,
+			&zmat,r,ybuff)!=CHOL_OK) {
+	  nrec=logNumErr(logfp,nrec,nbatch); stat=1; break;
+	}
+	nbatch=0;
+      }
+      nrec++;
+      reason=0;
+      if (type==REC_DOWNDATE) {
+	if (tmat.buff!=0)
+	  retcode=cholTileDnRk1(tmat.buff,n,tmat.nb,recbuff,0,cvec,svec,
+				wkvec,zmat.buff,r,zmat.stride,1,recbuff+n);
+	else
+	  retcode=cholDnRk1(lmat.buff,n,lmat.stride,islower,recbuff,0,cvec,
+			    svec,wkvec,zmat.buff,r,zmat.stride,1,recbuff+n);
+	if (retcode==CHOL_NOTPD) {
+	  reason="not positive definite"; retcode=CHOL_OK;
+	}
+      } else {
+	if (!(recbuff[0]>=1.0 && recbuff[0]<recbuff[1] &&
+		   recbuff[1]<=(double) n &&
+		   (recbuff[2]==1.0 || recbuff[2]==2.0)) ||
+		 recbuff[0]!=floor(recbuff[0]) || recbuff[1]!=floor(recbuff[1]))
+	  reason="invalid K, L, JOB";
+	else {
+	  k=(int) recbuff[0]; l=(int) recbuff[1]; job=(int) recbuff[2];
+	  /* A lower triangular L (leading dim. ldl) is a tiled buffer with
+	     nb = ldl, see chol_tiled.h */
+	  if (tmat.buff!=0)
+	    retcode=cholTileUpExch(tmat.buff,n,tmat.nb,k,l,job,0,1,1,0,
+				   zmat.buff,r,zmat.stride,1,cvec,svec);
+	  else if (islower)
+	    retcode=cholTileUpExch(lmat.buff,n,lmat.stride,k,l,job,0,1,1,0,
+				   zmat.buff,r,zmat.stride,1,cvec,svec);
+	  else
+	    retcode=cholUpExch(lmat.buff,n,lmat.stride,k,l,job,0,1,1,0,
+			       zmat.buff,r,zmat.stride,1,cvec,svec);
+	}
+      }
+      if (reason!=0) {
+	nrej++;
+	if (logfp!=0)
+	  fprintf(logfp,"Record %d: %s rejected (%s)\n",nrec,
+		  (type==REC_DOWNDATE)?"downdate":"exchange",reason);
+      } else if (retcode!=CHOL_OK) {
+	nrec=logNumErr(logfp,nrec,1); stat=1; break;
+      }
+    }
+    if (ckfname!=0 && ckfreq>0 && nrec%ckfreq==0) {
+      if (nbatch>0) {
+	if (updateBatch(&lmat,&tmat,islower,nbatch,vbuff,cvec,svec,wkvec,
+			&zmat,r,ybuff)!=CHOL_OK) {
+	  nrec=logNumErr(logfp,nrec,nbatch); stat=1; break;
+	}
+	nbatch=0;
+      }
+      if (!writeCheckpoint(ckfname,&lmat,&tmat,islower,&zmat,r,nrec,
+			   recbuff))
+	mexWarnMsgTxt("Cannot write checkpoint");
+    }
+  }
+  /* Remaining updates. Stream may have been corrupted after the last
+     complete record, which still has to be applied */
+  if (stat!=1 && nbatch>0 &&
+      updateBatch(&lmat,&tmat,islower,nbatch,vbuff,cvec,svec,wkvec,&zmat,r,
+		  ybuff)!=CHOL_OK) {
+    nrec=logNumErr(logfp,nrec,nbatch); stat=1;
+  }
+  if (stat!=1 && ckfname!=0 &&
+      !writeCheckpoint(ckfname,&lmat,&tmat,islower,&zmat,r,nrec,
+			   recbuff))
+    mexWarnMsgTxt("Cannot write checkpoint");
+  fclose(fp);
+  if (logfp!=0) fclose(logfp);
+
+  /* Deallocate */
+  mxFree((void*) cvec); mxFree((void*) svec); mxFree((void*) wkvec);
+  mxFree((void*) vbuff); mxFree((void*) ybuff); mxFree((void*) recbuff);
+  mxFree((void*) fname);
+  if (ckfname!=0) mxFree((void*) ckfname);
+  if (logfname!=0) mxFree((void*) logfname);
+
+  if (nlhs>0) {
+    plhs[0]=mxCreateDoubleMatrix(1,1,mxREAL);
+    *(mxGetPr(plhs[0]))=(double) stat;
+    if (nlhs>1) {
+      plhs[1]=mxCreateDoubleMatrix(1,1,mxREAL);
+      *(mxGetPr(plhs[1]))=(double) nrec;
+    }
+    if (nlhs>2) {
+      plhs[2]=mxCreateDoubleMatrix(1,1,mxREAL);
+      *(mxGetPr(plhs[2]))=(double) nrej;
+    }
+  }
+}
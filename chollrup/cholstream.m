@@ -0,0 +1,68 @@
+%CHOLSTREAM Apply stream of updates, downdates, exchanges to Cholesky factor
+%  [STAT,NREC,NREJ]=CHOLSTREAM(L,FNAME,{Z=[]},{KMAX=32},{CKFNAME=''},
+%    {CKFREQ=0},{LOGFNAME=''},{NSKIP=0})
+%
+%  ATTENTION: We use the undocumented fact that the content of
+%  matrices passed as arguments to a MEX function can be overwritten
+%  like in a proper call-by-reference. This is not officially
+%  supported and may not work in future Matlab versions!
+%
+%  Applies a stream of update, downdate and exchange records to the
+%  Cholesky factor L (lower or upper triangular, str. code UPLO, or
+%  tiled factor, see CHOLUPRK1), dragging along Z (r-by-n) if given. The
+%  stream is read from the file FNAME, which can also be a named pipe.
+%  This replaces one CHOLUPRK1, CHOLDNRK1 or CHOLUPEXCH call per record.
+%
+%  Record format:
+%  All entries are doubles in native byte order. A record starts with
+%  its type, followed by the payload:
+%  - 1 (update):   v [n], y [r]. A_ = A + v*v', Z_ L_' = Z L' + y v'
+%  - 2 (downdate): v [n], y [r]. A_ = A - v*v', Z_ L_' = Z L' - y v'
+%  - 3 (exchange): K, L, JOB. A_ = E' A E, see CHOLUPEXCH. Z is
+%                  replaced by Z_ = Z U', so that Z_ L_' = Z L' E
+%  A record is written by FWRITE(FID,[TYPE; PAYLOAD],'double').
+%  Runs of consecutive updates are grouped into rank-k updates with
+%  k <= KMAX, which sweep over L only once.
+%
+%  Rejected records:
+%  A downdate which would render A_ not positive definite, and an
+%  exchange with invalid K, L, JOB are rejected. L, Z are not modified,
+%  and the stream continues. If LOGFNAME is given, a line is appended to
+%  this file for each rejected record. A numerical error in the update
+%  sweep leaves L, Z undefined and stops the stream (STAT = 1). It is
+%  logged as well, naming the failing record (or the range of records of
+%  a grouped rank-k update).
+%
+%  Checkpointing:
+%  If CKFNAME is given, L and Z are written to this file after every
+%  CKFREQ records (0: only at the end of the stream). The file is
+%  written under CKFNAME.tmp first and then renamed, so CKFNAME always
+%  contains a complete checkpoint. Use CHOLCKLOAD to read it. A tiled
+%  factor is written as lower triangular L. To restart after a crash,
+%  pass the factor and Z from the checkpoint, together with NSKIP = NREC
+%  (from CHOLCKLOAD), so that the records already applied are skipped.
+%
+%  Input:
+%  - L:        Factor L (or L'), overwritten. Must be lower (upper)
+%              triangular, str. code UPLO. Or tiled factor
+%  - FNAME:    Record stream file name
+%  - Z:        Dragging along matrix [r-by-n]. Optional
+%  - KMAX:     Max. rank of grouped updates
+%  - CKFNAME:  Checkpoint file name ('': no checkpoints)
+%  - CKFREQ:   Checkpoint frequency (records)
+%  - LOGFNAME: Log file name for rejected records and numerical errors
+%              ('': no log)
+%  - NSKIP:    Number of records to skip at the start
+%
+%  Return:
+%  - STAT:     0 (OK), 1 (Numerical error), 2 (Stream corrupted)
+%  - NREC:     Number of records applied (or rejected), including NSKIP.
+%              Records of a failing update (STAT = 1) are not counted, so
+%              NREC+1 is the first record not applied
+%  - NREJ:     Number of rejected records
+%
+%  Instrumentation:
+%  If compiled with -DCHOL_INSTRUMENT (make MEXFLAGS=-DCHOL_INSTRUMENT),
+%  the kernels maintain hot-path counters. CHOLSTREAM('stats') returns them,
+%  CHOLSTREAM('reset') resets them, CHOLSTREAM('dump') prints them. See
+%  chol_instr.h for details.
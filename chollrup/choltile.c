@@ -0,0 +1,78 @@
+/* -------------------------------------------------------------------
+ * CHOLTILE
+ *
+ * ATTENTION: We use the undocumented fact that the content of
+ * matrices passed as arguments to a MEX function can be overwritten
+ * like in a proper call-by-reference. This is not officially
+ * supported and may not work in future Matlab versions!
+ *
+ * Conversion between normal and tiled storage of Cholesky factors.
+ * T=CHOLTILE(L,NB): L is a factor L or L' (lower or upper triangular,
+ * str. code UPLO, see CHOLUPRK1). Returns the buffer T of the tiled
+ * factor with tile size NB, which is passed to CHOLUPRK1, CHOLDNRK1,
+ * CHOLUPEXCH, CHOLSTREAM as { T, [n NB] }.
+ * CHOLTILE({T,[n NB]},L): Copies the tiled factor back into L (only the
+ * triangle given by UPLO is written).
+ *
+ * Tiled format:
+ * The tiled buffer always holds the lower triangular factor (for an
+ * upper triangular R passed in L, it holds R'). L is partitioned into
+ * NB-by-NB tiles, each of which is stored contiguously. The kernels
+ * sweep over L tile by tile, so that memory access is local even if L
+ * does not fit into the cache. For an upper triangular R, update and
+ * downdate are much faster on the tiled factor, and the exchange (which
+ * requires an upper triangular factor in normal storage) runs on L = R'.
+ * The tile size NB should be chosen so that a few tiles fit into the
+ * L2 cache (NB = 64 ... 256). See chol_tiled.h for details.
+ *
+ * Input:
+ * - L:     Factor L (or L'). Must be lower (upper) triangular, str. code
+ *          UPLO
+ * - NB:    Tile size
+ *
+ * Return:
+ * - T:     Tiled buffer
+ * -------------------------------------------------------------------
+ * Matlab MEX Function
+ * Author: Matthias Seeger
+ * ------------------------------------------------------------------- */
+
+#include <math.h>
+#include "mex.h"
+#include "mex_helper.h"
+#include "chol_tiled.h"
+
+char errMsg[200];
+
+/* Main function CHOLTILE */
+
+void mexFunction(int nlhs,mxArray *plhs[],int nrhs,const mxArray *prhs[])
+{
+  int n,nb;
+  fst_matrix lmat;
+  tiled_matrix tmat;
+  bool islower,totiled;
+
+  /* Read arguments */
+  if (nrhs<2)
+    mexErrMsgTxt("Not enough input arguments");
+  totiled=!parseTiledMatrix(prhs[0],"T",&tmat);
+  if (totiled && nlhs!=1)
+    mexErrMsgTxt("Need one return argument");
+  if (!totiled && nlhs>0)
+    mexErrMsgTxt("Too many return arguments");
+  parseBLASMatrix(prhs[totiled?0:1],"L",&lmat,-1,-1);
+  if ((n=lmat.n)!=lmat.m ||
+      (!(islower=(UPLO(lmat.strcode)=='L')) && UPLO(lmat.strcode)!='U'))
+    mexErrMsgTxt("L must be lower/upper triangular (use UPLO str. code!)");
+  if (totiled) {
+    if ((nb=getScalInt(prhs[1],"NB"))<1)
+      mexErrMsgTxt("NB must be positive");
+    plhs[0]=mxCreateDoubleMatrix(cholTileSize(n,nb),1,mxREAL);
+    cholTileFromCM(mxGetPr(plhs[0]),n,nb,lmat.buff,lmat.stride,islower);
+  } else {
+    if (tmat.n!=n)
+      mexErrMsgTxt("L has wrong size");
+    cholTileToCM(tmat.buff,n,tmat.nb,lmat.buff,lmat.stride,islower);
+  }
+}
@@ -0,0 +1,35 @@
+%CHOLTILE Convert Cholesky factor to/from tiled storage
+%  T=CHOLTILE(L,NB)
+%  CHOLTILE({T,[N NB]},L)
+%
+%  ATTENTION: We use the undocumented fact that the content of
+%  matrices passed as arguments to a MEX function can be overwritten
+%  like in a proper call-by-reference. This is not officially
+%  supported and may not work in future Matlab versions!
+%
+%  Conversion between normal and tiled storage of Cholesky factors.
+%  T=CHOLTILE(L,NB): L is a factor L or L' (lower or upper triangular,
+%  str. code UPLO, see CHOLUPRK1). Returns the buffer T of the tiled
+%  factor with tile size NB, which is passed to CHOLUPRK1, CHOLDNRK1,
+%  CHOLUPEXCH, CHOLSTREAM as { T, [n NB] }.
+%  CHOLTILE({T,[n NB]},L): Copies the tiled factor back into L (only the
+%  triangle given by UPLO is written).
+%
+%  Tiled format:
+%  The tiled buffer always holds the lower triangular factor (for an
+%  upper triangular R passed in L, it holds R'). L is partitioned into
+%  NB-by-NB tiles, each of which is stored contiguously. The kernels
+%  sweep over L tile by tile, so that memory access is local even if L
+%  does not fit into the cache. For an upper triangular R, update and
+%  downdate are much faster on the tiled factor, and the exchange (which
+%  requires an upper triangular factor in normal storage) runs on L = R'.
+%  The tile size NB should be chosen so that a few tiles fit into the
+%  L2 cache (NB = 64 ... 256). See chol_tiled.h for details.
+%
+%  Input:
+%  - L:     Factor L (or L'). Must be lower (upper) triangular, str. code
+%           UPLO
+%  - NB:    Tile size
+%
+%  Return:
+%  - T:     Tiled buffer
@@ -24,8 +24,8 @@
  * Dragging along: If X is passed, it is replaced by X_ = U X. Note
  * that if R' X = B, then (R_)' X_ = E' B
  *
- * The method is just a wrapper around the LINPACK routine DCHEX. For
- * more information, see
+ * The method is just a wrapper around the LINPACK routine DCHEX, see
+ * 'cholUpExch' in chol_kernels.h. For more information, see
  * @book{Dongarra:79,
  *   author      = {Dongarra, J. and Moler, C. and Bunch, J. and Stewart, G.},
  *   title       = {{LINPACK} User's Guide},
@@ -36,11 +36,22 @@
  * negative. We include a workaround here.
  *
  * Input:
- * - R:     Factor R, overwritten by R_
+ * - R:     Factor R, overwritten by R_. Or tiled factor
  * - K:     Describes E (s.a.)
  * - L:     Describes E (s.a.)
  * - JOB:   Describes E (s.a.)
  * - X:     Drag-along matrix, replaced by X_ [def: []]
+ *
+ * Tiled factor:
+ * R can also be a tiled factor { TBUFF, [n NB] } created by CHOLTILE,
+ * which holds L = R'. In this case, 'cholTileUpExch' is used instead of
+ * DCHEX, which is faster for large n. See chol_tiled.h.
+ *
+ * Instrumentation:
+ * If compiled with -DCHOL_INSTRUMENT (make MEXFLAGS=-DCHOL_INSTRUMENT),
+ * the kernels maintain hot-path counters. CHOLUPEXCH('stats') returns them,
+ * CHOLUPEXCH('reset') resets them, CHOLUPEXCH('dump') prints them. See
+ * chol_instr.h for details.
  * -------------------------------------------------------------------
  * Matlab MEX Function
  * Author: Matthias Seeger
@@ -49,29 +60,33 @@
 #include <math.h>
 #include "mex.h"
 #include "mex_helper.h" /* Helper functions */
-#include "blas_headers.h"
+#include "chol_tiled.h"
 
 char errMsg[200];
 
-/* LINPACK DCHEX declaration */
-extern void BLASFUNC(dchex) (double* r,int* ldr,int* p,int* k,int* l,
-			     double* z,int* ldz,int* nz,double* c,double* s,
-			     int* job);
-
 /* Main function CHOLUPEXCH */
 
 void mexFunction(int nlhs,mxArray *plhs[],int nrhs,const mxArray *prhs[])
 {
-  int n,k,l,job,nz=0,farg1,j;
+  int n,k,l,job,nz=0;
   double* rfact,*xmat=0,*cvec,*svec;
-  double temp;
+  tiled_matrix tmat;
+  bool istiled;
+
+  /* Instrumentation commands */
+  if (cholInstrMexCmd(nlhs,plhs,nrhs,prhs))
+    return;
 
   /* Read arguments */
   if (nrhs<4)
     mexErrMsgTxt("Not enough input arguments");
-  if (!mxIsDouble(prhs[0]) || (n=mxGetM(prhs[0]))!=mxGetN(prhs[0]))
-    mexErrMsgTxt("Wrong argument R");
-  rfact=mxGetPr(prhs[0]);
+  if (!(istiled=parseTiledMatrix(prhs[0],"R",&tmat))) {
+    if (!mxIsDouble(prhs[0]) || (n=mxGetM(prhs[0]))!=mxGetN(prhs[0]))
+      mexErrMsgTxt("Wrong argument R");
+    rfact=mxGetPr(prhs[0]);
+  } else {
+    n=tmat.n; rfact=tmat.buff;
+  }
   if ((k=getScalInt(prhs[1],"K"))<1)
     mexErrMsgTxt("Wrong argument K");
   l=getScalInt(prhs[2],"L");
@@ -90,18 +105,11 @@ void mexFunction(int nlhs,mxArray *plhs[],int nrhs,const mxArray *prhs[])
   cvec=(double*) mxMalloc(n*sizeof(double));
   svec=(double*) mxMalloc(n*sizeof(double));
 
-  /* Call DCHEX */
-  BLASFUNC(dchex) (rfact,&n,&n,&k,&l,xmat,&n,&nz,cvec,svec,&job);
-  /* There is a strange bug in DCHEX. In some cases,
-     R(j,j) < 0 for some k<=j<=l, the whole corr. row has to be multiplied
-     by -1 to get the correct Cholesky factor. Here is a workaround. */
-  for (j=k; j<=l; j++)
-    if (rfact[(j-1)*(n+1)]<0) {
-      farg1=n-j+1; temp=-1.0;
-      BLASFUNC(dscal) (&farg1,&temp,rfact+((j-1)*(n+1)),&n);
-      if (nz!=0)
-	BLASFUNC(dscal) (&nz,&temp,xmat+(j-1),&n);
-    }
+  /* Call DCHEX (with workaround for negative DIAG(R_)) */
+  if (istiled)
+    cholTileUpExch(rfact,n,tmat.nb,k,l,job,xmat,n,1,nz,0,0,1,1,cvec,svec);
+  else
+    cholUpExch(rfact,n,n,k,l,job,xmat,n,1,nz,0,0,1,1,cvec,svec);
 
   /* Deallocate */
   mxFree((void*) cvec); mxFree((void*) svec);
@@ -27,3 +27,14 @@
 %  The method is just a wrapper around the LINPACK routine DCHEX
 %  NOTE: There is a bug in DCHEX, causing elements of DIAG(R_) to be
 %  negative. We include a workaround here.
+%
+%  Tiled factor:
+%  R can also be a tiled factor { TBUFF, [n NB] } created by CHOLTILE,
+%  which holds L = R'. In this case, DCHEX is replaced by a port to the
+%  tiled format, which is faster for large n. See chol_tiled.h.
+%
+%  Instrumentation:
+%  If compiled with -DCHOL_INSTRUMENT (make MEXFLAGS=-DCHOL_INSTRUMENT),
+%  the kernels maintain hot-path counters. CHOLUPEXCH('stats') returns them,
+%  CHOLUPEXCH('reset') resets them, CHOLUPEXCH('dump') prints them. See
+%  chol_instr.h for details.
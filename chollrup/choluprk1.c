@@ -31,7 +31,7 @@
  *
  * Input:
  * - L:     Factor L (or L'), overwritten by L_ (or L_'). Must be
- *          lower (upper) triangular, str. code UPLO
+ *          lower (upper) triangular, str. code UPLO. Or tiled factor
  * - VEC:   Vector v. Can have size >n, only first n elem. are used
  * - CVEC:  Vector [n]. c_k ret. here
  * - SVEC:  Vector [n]. s_k ret. here
@@ -41,6 +41,17 @@
  *
  * Return:
  * - STAT:  0 (OK), 1 (Numerical error)
+ *
+ * Tiled factor:
+ * L can also be a tiled factor { TBUFF, [n NB] } created by CHOLTILE
+ * (always holds L, not L'). For large n, this is faster than passing
+ * L' (upper triangular). See chol_tiled.h.
+ *
+ * Instrumentation:
+ * If compiled with -DCHOL_INSTRUMENT (make MEXFLAGS=-DCHOL_INSTRUMENT),
+ * the kernels maintain hot-path counters. CHOLUPRK1('stats') returns them,
+ * CHOLUPRK1('reset') resets them, CHOLUPRK1('dump') prints them. See
+ * chol_instr.h for details.
  * -------------------------------------------------------------------
  * Matlab MEX Function
  * Author: Matthias Seeger
@@ -49,53 +60,52 @@
 #include <math.h>
 #include "mex.h"
 #include "mex_helper.h"
-#include "blas_headers.h"
+#include "chol_tiled.h"
 
 char errMsg[200];
 
 /*
- * The method is adapted from LINPACK dchud. We did the following
- * modifications:
- * - Using BLAS drot in order to avoid any explicit O(n^2) loops
- * - Keeping diag(L_) positive, by flipping angles c_k, s_k whenever
- *   a negative element pops up
- * See the TR
- *   M. Seeger
- *   Low Rank Updates for the Cholesky Decomposition
- *   Available at: www.kyb.tuebingen.mpg.de/bs/people/seeger/papers/
+ * The method is implemented in 'cholUpRk1', see chol_kernels.h.
  */
 
 /* Main function CHOLUPRK1 */
 
 void mexFunction(int nlhs,mxArray *plhs[],int nrhs,const mxArray *prhs[])
 {
-  int i,n,r=0,stp,sz,ione=1,retcode=0;
-  double temp;
+  int i,n,r=0,retcode;
   fst_matrix lmat,zmat;
+  tiled_matrix tmat;
   const double* vvec;
-  double* cvec,*svec,*wkvec,*yvec;
-  bool islower;
-  double* tbuff;
+  double* cvec,*svec,*wkvec,*yvec=0;
+  bool istiled,islower;
+
+  /* Instrumentation commands */
+  if (cholInstrMexCmd(nlhs,plhs,nrhs,prhs))
+    return;
 
   /* Read arguments */
   if (nrhs<5)
     mexErrMsgTxt("Not enough input arguments");
   if (nlhs>1)
     mexErrMsgTxt("Too many return arguments");
-  parseBLASMatrix(prhs[0],"L",&lmat,-1,-1);
-  /*
-  sprintf(errMsg,"%d, %d, '%s', %c\n",lmat.m,lmat.n,lmat.strcode,
-	  UPLO(lmat.strcode));
-  mexPrintf(errMsg);
-  */
-  if ((n=lmat.n)!=lmat.m ||
-      (!(islower=(UPLO(lmat.strcode)=='L')) && UPLO(lmat.strcode)!='U'))
-    mexErrMsgTxt("L must be lower/upper triangular (use UPLO str. code!)");
+  if (!(istiled=parseTiledMatrix(prhs[0],"L",&tmat))) {
+    parseBLASMatrix(prhs[0],"L",&lmat,-1,-1);
+    /*
+    sprintf(errMsg,"%d, %d, '%s', %c\n",lmat.m,lmat.n,lmat.strcode,
+	    UPLO(lmat.strcode));
+    mexPrintf(errMsg);
+    */
+    if ((n=lmat.n)!=lmat.m ||
+	(!(islower=(UPLO(lmat.strcode)=='L')) && UPLO(lmat.strcode)!='U'))
+      mexErrMsgTxt("L must be lower/upper triangular (use UPLO str. code!)");
+  } else
+    n=tmat.n;
   if (getVecLen(prhs[1],"VEC")<n) mexErrMsgTxt("VEC too short");
   vvec=mxGetPr(prhs[1]);
   if (getVecLen(prhs[2],"CVEC")!=n || getVecLen(prhs[3],"SVEC")!=n)
     mexErrMsgTxt("CVEC, SVEC have wrong size");
   cvec=mxGetPr(prhs[2]); svec=mxGetPr(prhs[3]);
+  zmat.buff=0; zmat.stride=1;
   if (nrhs>5) {
     if (nrhs<7) mexErrMsgTxt("Need both Z, Y");
     parseBLASMatrix(prhs[5],"Z",&zmat,-1,n);
@@ -107,43 +117,13 @@ void mexFunction(int nlhs,mxArray *plhs[],int nrhs,const mxArray *prhs[])
   if (i<n || i<r) mexErrMsgTxt("WORKV too short");
   wkvec=mxGetPr(prhs[4]);
 
-  /* Generate Givens rotations, update L */
-  BLASFUNC(dcopy) (&n,vvec,&ione,wkvec,&ione);
-  stp=islower?1:lmat.stride;
-  for (i=0,sz=n,tbuff=lmat.buff; i<n-1; i++) {
-    /* drotg(a,b,c,s): J = [c s; -s c], s.t. J [a; b] = [r; 0]
-       a overwritten by r, b by some other information (NOT 0!) */
-    if (*tbuff==0.0 && wkvec[i]==0.0) {
-      retcode=1; break;
-    }
-    BLASFUNC(drotg) (tbuff,wkvec+i,cvec+i,svec+i);
-    /* Do not want negative elements on factor diagonal */
-    if ((temp=*tbuff)<0.0) {
-      *tbuff=-temp; cvec[i]=-cvec[i]; svec[i]=-svec[i];
-    } else if (temp==0.0) {
-      retcode=1; break;
-    }
-    /* drot(x,y,c,s): J = [c s; -s c]. [x_i; y_i] overwritten by
-       J [x_i; y_i], for all i
-       BAD: Slower for upper triangular! */
-    sz--;
-    BLASFUNC(drot) (&sz,tbuff+stp,&stp,wkvec+(i+1),&ione,cvec+i,svec+i);
-    tbuff+=(lmat.stride+1);
-  }
-  if (retcode==0 && (*tbuff!=0.0 || wkvec[n-1]!=0.0)) {
-    BLASFUNC(drotg) (tbuff,wkvec+(n-1),cvec+i,svec+i);
-    if ((temp=*tbuff)<0.0) {
-      *tbuff=-temp; cvec[i]=-cvec[i]; svec[i]=-svec[i];
-    } else if (temp==0.0) retcode=1;
-  } else retcode=1;
-
-  /* Dragging along */
-  if (r>0 && retcode==0) {
-    BLASFUNC(dcopy) (&r,yvec,&ione,wkvec,&ione);
-    for (i=0; i<n; i++)
-      BLASFUNC(drot) (&r,zmat.buff+(i*zmat.stride),&ione,wkvec,&ione,cvec+i,
-		      svec+i);
-  }
+  /* Update L, drag along Z */
+  if (istiled)
+    retcode=cholTileUpRk1(tmat.buff,n,tmat.nb,vvec,cvec,svec,wkvec,
+			  zmat.buff,r,zmat.stride,1,yvec);
+  else
+    retcode=cholUpRk1(lmat.buff,n,lmat.stride,islower,vvec,cvec,svec,wkvec,
+		      zmat.buff,r,zmat.stride,1,yvec);
 
   if (nlhs==1) {
     plhs[0]=mxCreateDoubleMatrix(1,1,mxREAL);
@@ -28,3 +28,14 @@
 %  NOTE: The same vector can be passed for VEC and WORKV, in which case
 %  VEC is overwritten in an undefined way. If r > n, VEC can be of size
 %  r, containing v in the first n components.
+%
+%  Tiled factor:
+%  L can also be a tiled factor { TBUFF, [n NB] } created by CHOLTILE
+%  (always holds L, not L'). For large n, this is faster than passing
+%  L' (upper triangular). See chol_tiled.h.
+%
+%  Instrumentation:
+%  If compiled with -DCHOL_INSTRUMENT (make MEXFLAGS=-DCHOL_INSTRUMENT),
+%  the kernels maintain hot-path counters. CHOLUPRK1('stats') returns them,
+%  CHOLUPRK1('reset') resets them, CHOLUPRK1('dump') prints them. See
+%  chol_instr.h for details.
@@ -0,0 +1,386 @@
+/* -------------------------------------------------------------------
+ * PYCHOLLRUP
+ *
+ * Python extension module over the kernels in chol_kernels.h. The
+ * factor (and Z, X) are NumPy arrays, which are overwritten in place.
+ * Nothing is copied: the kernels run directly on the array buffers.
+ *
+ * Factor argument:
+ * L is a square float64 array, L or L' (lower or upper triangular, as
+ * given by UPLO, 'L' or 'U'). Only the relevant triangle is accessed.
+ * L can be Fortran- or C-ordered (also a view, as long as one of the
+ * strides is 8 bytes). A C-ordered L is the column-major buffer of L',
+ * so it is passed to the kernels with the opposite UPLO. Hence, for the
+ * faster lower triangular variant (see CHOLUPRK1), use UPLO = 'L' with
+ * Fortran order, or UPLO = 'U' with C order.
+ * Z (r-by-n) and X (n-by-nz) can be Fortran- or C-ordered (also a view
+ * with positive strides). The kernels take their row and column
+ * strides, so they are not copied either. Vectors are converted to
+ * float64 if needed.
+ *
+ * Functions (semantics as for the MEX functions of the same names,
+ * keyword names as given here):
+ * - STAT=uprk1(L,v,uplo='L',z=None,y=None,cvec=None,svec=None)
+ * - STAT=dnrk1(L,v,uplo='L',isp=False,z=None,y=None,cvec=None,
+ *     svec=None)
+ * - upexch(R,k,l,job,uplo='U',x=None,z=None). k, l are 1-based, as for
+ *   CHOLUPEXCH. The factor can be upper (DCHEX) or lower triangular
+ *   ('cholTileUpExch' with nb = ldl, see chol_tiled.h). Z (r-by-n) is
+ *   replaced by Z U' (see CHOLSTREAM)
+ * - instr_stats(), instr_reset(), instr_dump(): Instrumentation, see
+ *   chol_instr.h. instr_stats returns CHOL_INSTR_NVAL-by-3 array
+ * STAT is 0 (OK), 1 (Numerical error). cvec, svec are optional
+ * float64 vectors of size n, which receive the Givens rotations.
+ *
+ * Threads:
+ * The GIL is released while the kernels run, so that several Python
+ * threads can update different factors concurrently. Do not pass the
+ * same factor (or Z, X) to concurrent calls. The instrumentation
+ * counters (-DCHOL_INSTRUMENT) are updated by atomic adds, so no counts
+ * are lost (see chol_instr.h).
+ *
+ * Build: make python (see setup.py)
+ * -------------------------------------------------------------------
+ * Python Extension Module
+ * Author: Matthias Seeger
+ * ------------------------------------------------------------------- */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "chol_tiled.h"
+
+/*
+ * Checks array to be overwritten in place: float64, native byte order,
+ * aligned, writeable, 'ndim' dimensions. Returns false (exception set)
+ * otherwise.
+ */
+bool checkInPlace(PyObject* obj,const char* name,int ndim)
+{
+  PyArrayObject* arr;
+
+  if (!PyArray_Check(obj)) {
+    PyErr_Format(PyExc_TypeError,"%s must be a NumPy array",name);
+    return false;
+  }
+  arr=(PyArrayObject*) obj;
+  if (PyArray_TYPE(arr)!=NPY_DOUBLE || !PyArray_ISNOTSWAPPED(arr) ||
+      !PyArray_ISALIGNED(arr) || !PyArray_ISWRITEABLE(arr)) {
+    PyErr_Format(PyExc_ValueError,
+		 "%s must be an aligned, writeable float64 array",name);
+    return false;
+  }
+  if (PyArray_NDIM(arr)!=ndim) {
+    PyErr_Format(PyExc_ValueError,"%s must have %d dimension(s)",name,
+		 ndim);
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Parses factor argument (see header comment). 'islower' is set for
+ * the column-major buffer, i.e. it is flipped for C order.
+ */
+bool parseFactor(PyObject* obj,const char* name,const char* uplo,
+		 double** buff,int* n,int* ld,int* islower)
+{
+  PyArrayObject* arr;
+  npy_intp s0,s1,es=sizeof(double);
+
+  if (!checkInPlace(obj,name,2))
+    return false;
+  if ((uplo[0]!='L' && uplo[0]!='U') || uplo[1]!='\0') {
+    PyErr_SetString(PyExc_ValueError,"UPLO must be 'L' or 'U'");
+    return false;
+  }
+  arr=(PyArrayObject*) obj;
+  if ((*n=(int) PyArray_DIM(arr,0))!=PyArray_DIM(arr,1) || *n<1) {
+    PyErr_Format(PyExc_ValueError,"%s must be square",name);
+    return false;
+  }
+  s0=PyArray_STRIDE(arr,0); s1=PyArray_STRIDE(arr,1);
+  *buff=(double*) PyArray_DATA(arr);
+  if (*n==1) {
+    *ld=1; *islower=(uplo[0]=='L');
+  } else if (s0==es && s1>0 && s1%es==0 && s1/es>=*n) {
+    /* Fortran order */
+    *ld=(int) (s1/es); *islower=(uplo[0]=='L');
+  } else if (s1==es && s0>0 && s0%es==0 && s0/es>=*n) {
+    /* C order: buffer holds the transpose */
+    *ld=(int) (s0/es); *islower=(uplo[0]=='U');
+  } else {
+    PyErr_Format(PyExc_ValueError,
+		 "%s must be Fortran- or C-ordered (unit stride along one axis)",
+		 name);
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Parses matrix argument (Z, X) with 'm' rows ('m' < 0: any) and 'n'
+ * columns ('n' < 0: any). Element (i,j) is buff[i*inc+j*ld], where 'inc'
+ * and 'ld' are the strides in units of doubles. Any order is fine, as
+ * long as the strides are positive. None is allowed, then 'buff' is set
+ * to 0.
+ */
+bool parseStridedMatrix(PyObject* obj,const char* name,int m,int n,
+			double** buff,int* rows,int* cols,int* ld,int* inc)
+{
+  PyArrayObject* arr;
+  npy_intp s0,s1,es=sizeof(double);
+
+  *buff=0; *rows=*cols=0; *ld=*inc=1;
+  if (obj==0 || obj==Py_None)
+    return true;
+  if (!checkInPlace(obj,name,2))
+    return false;
+  arr=(PyArrayObject*) obj;
+  *rows=(int) PyArray_DIM(arr,0); *cols=(int) PyArray_DIM(arr,1);
+  if ((m>=0 && *rows!=m) || (n>=0 && *cols!=n)) {
+    PyErr_Format(PyExc_ValueError,"%s has wrong size",name);
+    return false;
+  }
+  /* Stride along an axis of size 1 is never used */
+  s0=(*rows>1)?PyArray_STRIDE(arr,0):es;
+  s1=(*cols>1)?PyArray_STRIDE(arr,1):es;
+  if (s0<=0 || s1<=0 || s0%es!=0 || s1%es!=0 || s0/es>INT_MAX ||
+      s1/es>INT_MAX) {
+    PyErr_Format(PyExc_ValueError,"%s must have positive strides",name);
+    return false;
+  }
+  *inc=(int) (s0/es); *ld=(int) (s1/es);
+  *buff=(double*) PyArray_DATA(arr);
+  return true;
+}
+
+/*
+ * Input vector of size >= 'n' ('exact': == n). Returns new reference
+ * (may be a converted copy), or 0 (exception set).
+ */
+PyArrayObject* getInVector(PyObject* obj,const char* name,int n,bool exact)
+{
+  PyArrayObject* arr;
+
+  arr=(PyArrayObject*) PyArray_FROMANY(obj,NPY_DOUBLE,1,1,
+				       NPY_ARRAY_IN_ARRAY);
+  if (arr==0)
+    return 0;
+  if (PyArray_DIM(arr,0)<n || (exact && PyArray_DIM(arr,0)!=n)) {
+    Py_DECREF(arr);
+    PyErr_Format(PyExc_ValueError,"%s has wrong size",name);
+    return 0;
+  }
+  return arr;
+}
+
+/*
+ * Output vector of size n (CVEC, SVEC). If None, 'buff' is allocated
+ * and 'isalloc' is set.
+ */
+bool getOutVector(PyObject* obj,const char* name,int n,double** buff,
+		  bool* isalloc)
+{
+  PyArrayObject* arr;
+
+  *isalloc=(obj==0 || obj==Py_None);
+  if (*isalloc) {
+    if ((*buff=(double*) malloc(n*sizeof(double)))==0) {
+      PyErr_NoMemory();
+      return false;
+    }
+    return true;
+  }
+  if (!checkInPlace(obj,name,1))
+    return false;
+  arr=(PyArrayObject*) obj;
+  if (PyArray_DIM(arr,0)!=n || !PyArray_IS_C_CONTIGUOUS(arr)) {
+    PyErr_Format(PyExc_ValueError,"%s must be contiguous, size n",name);
+    return false;
+  }
+  *buff=(double*) PyArray_DATA(arr);
+  return true;
+}
+
+/*
+ * Common part of 'uprk1' and 'dnrk1'
+ */
+PyObject* updateCommon(PyObject* args,PyObject* kwds,bool isdown)
+{
+  static char* kwlist1[]={"L","v","uplo","z","y","cvec","svec",0};
+  static char* kwlist2[]={"L","v","uplo","isp","z","y","cvec","svec",0};
+  PyObject* lobj,*vobj,*zobj=0,*yobj=0,*cobj=0,*sobj=0;
+  PyArrayObject* varr=0,*yarr=0;
+  const char* uplo="L";
+  int n,ld,islower,isp=0,r,zn,ldz,incz,retcode=CHOL_OK;
+  double* lbuff,*zbuff,*cvec=0,*svec=0,*wkvec=0;
+  bool cisalloc=false,sisalloc=false,ok=false;
+
+  if (!isdown) {
+    if (!PyArg_ParseTupleAndKeywords(args,kwds,"OO|sOOOO",kwlist1,&lobj,
+				     &vobj,&uplo,&zobj,&yobj,&cobj,&sobj))
+      return 0;
+  } else if (!PyArg_ParseTupleAndKeywords(args,kwds,"OO|spOOOO",kwlist2,
+					  &lobj,&vobj,&uplo,&isp,&zobj,
+					  &yobj,&cobj,&sobj))
+    return 0;
+  if (!parseFactor(lobj,"L",uplo,&lbuff,&n,&ld,&islower) ||
+      (varr=getInVector(vobj,"v",n,false))==0 ||
+      !parseStridedMatrix(zobj,"z",-1,n,&zbuff,&r,&zn,&ldz,&incz))
+    goto done;
+  if ((zbuff!=0)!=(yobj!=0 && yobj!=Py_None)) {
+    PyErr_SetString(PyExc_ValueError,"Need both z, y");
+    goto done;
+  }
+  if (zbuff!=0 && (yarr=getInVector(yobj,"y",r,true))==0)
+    goto done;
+  if (!getOutVector(cobj,"cvec",n,&cvec,&cisalloc) ||
+      !getOutVector(sobj,"svec",n,&svec,&sisalloc))
+    goto done;
+  if ((wkvec=(double*) malloc(((n>r)?n:r)*sizeof(double)))==0) {
+    PyErr_NoMemory();
+    goto done;
+  }
+
+  /* Update L, drag along Z */
+  Py_BEGIN_ALLOW_THREADS
+  if (!isdown)
+    retcode=cholUpRk1(lbuff,n,ld,islower,(double*) PyArray_DATA(varr),cvec,
+		      svec,wkvec,zbuff,r,ldz,incz,
+		      (yarr!=0)?((double*) PyArray_DATA(yarr)):0);
+  else
+    retcode=cholDnRk1(lbuff,n,ld,islower,(double*) PyArray_DATA(varr),isp,
+		      cvec,svec,wkvec,zbuff,r,ldz,incz,
+		      (yarr!=0)?((double*) PyArray_DATA(yarr)):0);
+  Py_END_ALLOW_THREADS
+  ok=true;
+
+ done:
+  Py_XDECREF(varr); Py_XDECREF(yarr);
+  if (cisalloc) free((void*) cvec);
+  if (sisalloc) free((void*) svec);
+  if (wkvec!=0) free((void*) wkvec);
+  if (!ok)
+    return 0;
+  return PyLong_FromLong((retcode==CHOL_OK)?0:1);
+}
+
+PyObject* py_uprk1(PyObject* self,PyObject* args,PyObject* kwds)
+{
+  return updateCommon(args,kwds,false);
+}
+
+PyObject* py_dnrk1(PyObject* self,PyObject* args,PyObject* kwds)
+{
+  return updateCommon(args,kwds,true);
+}
+
+PyObject* py_upexch(PyObject* self,PyObject* args,PyObject* kwds)
+{
+  static char* kwlist[]={"R","k","l","job","uplo","x","z",0};
+  PyObject* robj,*xobj=0,*zobj=0;
+  const char* uplo="U";
+  int n,ld,islower,k,l,job,nx,nz,ldx,incx,r,zn,ldz,incz;
+  double* rbuff,*xbuff,*zbuff,*cvec,*svec;
+
+  if (!PyArg_ParseTupleAndKeywords(args,kwds,"Oiii|sOO",kwlist,&robj,&k,
+				   &l,&job,&uplo,&xobj,&zobj))
+    return 0;
+  if (!parseFactor(robj,"R",uplo,&rbuff,&n,&ld,&islower))
+    return 0;
+  if (k<1 || l<=k || l>n || job<1 || job>2) {
+    PyErr_SetString(PyExc_ValueError,"Wrong arguments K, L, JOB");
+    return 0;
+  }
+  if (!parseStridedMatrix(xobj,"x",n,-1,&xbuff,&nx,&nz,&ldx,&incx) ||
+      !parseStridedMatrix(zobj,"z",-1,n,&zbuff,&r,&zn,&ldz,&incz))
+    return 0;
+  cvec=(double*) malloc(n*sizeof(double));
+  svec=(double*) malloc(n*sizeof(double));
+  if (cvec==0 || svec==0) {
+    free((void*) cvec); free((void*) svec);
+    return PyErr_NoMemory();
+  }
+
+  /* A lower triangular L (leading dim. ld) is a tiled buffer with
+     nb = ld, see chol_tiled.h */
+  Py_BEGIN_ALLOW_THREADS
+  if (islower)
+    cholTileUpExch(rbuff,n,ld,k,l,job,xbuff,ldx,incx,nz,zbuff,r,ldz,incz,
+		   cvec,svec);
+  else
+    cholUpExch(rbuff,n,ld,k,l,job,xbuff,ldx,incx,nz,zbuff,r,ldz,incz,cvec,
+	       svec);
+  Py_END_ALLOW_THREADS
+
+  free((void*) cvec); free((void*) svec);
+  Py_RETURN_NONE;
+}
+
+PyObject* py_instr_stats(PyObject* self,PyObject* args)
+{
+  npy_intp dims[2]={CHOL_INSTR_NVAL,CHOL_NKERN};
+  PyArrayObject* arr;
+  double* vals;
+  int i,k;
+  double tmp[CHOL_INSTR_NVAL];
+
+  if ((arr=(PyArrayObject*) PyArray_SimpleNew(2,dims,NPY_DOUBLE))==0)
+    return 0;
+  vals=(double*) PyArray_DATA(arr);
+  for (k=0; k<CHOL_NKERN; k++) {
+    cholInstrQuery(k,tmp);
+    for (i=0; i<CHOL_INSTR_NVAL; i++)
+      vals[i*CHOL_NKERN+k]=tmp[i];
+  }
+  return (PyObject*) arr;
+}
+
+PyObject* py_instr_reset(PyObject* self,PyObject* args)
+{
+  cholInstrReset();
+  Py_RETURN_NONE;
+}
+
+PyObject* py_instr_dump(PyObject* self,PyObject* args)
+{
+  cholInstrDump(printf);
+  fflush(stdout);
+  Py_RETURN_NONE;
+}
+
+static PyMethodDef pychollrupMethods[]={
+  {"uprk1",(PyCFunction) py_uprk1,METH_VARARGS|METH_KEYWORDS,
+   "STAT=uprk1(L,v,uplo='L',z=None,y=None,cvec=None,svec=None)\n"
+   "Rank one update of Cholesky factor L (in place). See CHOLUPRK1."},
+  {"dnrk1",(PyCFunction) py_dnrk1,METH_VARARGS|METH_KEYWORDS,
+   "STAT=dnrk1(L,v,uplo='L',isp=False,z=None,y=None,cvec=None,svec=None)\n"
+   "Rank one downdate of Cholesky factor L (in place). See CHOLDNRK1."},
+  {"upexch",(PyCFunction) py_upexch,METH_VARARGS|METH_KEYWORDS,
+   "upexch(R,k,l,job,uplo='U',x=None,z=None)\n"
+   "Exchange update of Cholesky factor R (in place). See CHOLUPEXCH."},
+  {"instr_stats",py_instr_stats,METH_NOARGS,
+   "Instrumentation counters (see chol_instr.h)"},
+  {"instr_reset",py_instr_reset,METH_NOARGS,
+   "Resets instrumentation counters"},
+  {"instr_dump",py_instr_dump,METH_NOARGS,
+   "Prints instrumentation counters"},
+  {0,0,0,0}
+};
+
+static struct PyModuleDef pychollrupModule={
+  PyModuleDef_HEAD_INIT,"pychollrup",
+  "Cholesky rank one updates, downdates, exchanges on NumPy arrays "
+  "(in place, releasing the GIL). See pychollrup.c.",-1,
+  pychollrupMethods
+};
+
+PyMODINIT_FUNC PyInit_pychollrup(void)
+{
+  import_array();
+  return PyModule_Create(&pychollrupModule);
+}
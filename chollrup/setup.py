@@ -0,0 +1,22 @@
+# Build the Python extension module pychollrup (see pychollrup.c):
+#   make python
+# which compiles dchex.o and runs
+#   python setup.py build_ext --inplace --force
+# BLAS libraries are given by BLAS_LIBS (default: 'blas'), for example
+#   BLAS_LIBS="openblas gfortran" make python
+# For hot-path counters: make python MEXFLAGS=-DCHOL_INSTRUMENT
+
+import os
+import numpy
+from setuptools import setup, Extension
+
+libs = os.environ.get('BLAS_LIBS', 'blas').split()
+macros = [(f[2:], None) for f in os.environ.get('MEXFLAGS', '').split()
+          if f.startswith('-D')]
+
+setup(
+    name='pychollrup',
+    ext_modules=[Extension(
+        'pychollrup', sources=['pychollrup.c'],
+        include_dirs=[numpy.get_include()], define_macros=macros,
+        extra_objects=['dchex.o'], libraries=libs)])
@@ -0,0 +1,77 @@
+% Test of the instrumentation counters. The MEX files must be compiled
+% with counters:
+%   make clean; make MEXFLAGS=-DCHOL_INSTRUMENT
+maxlam=2; minlam=0.1;
+nvec=[100 300]; nup=5; ndn=4; nrej=2; nex=3;
+% Rows of counter matrix (see chol_instr.h): calls, fails, flips, flops,
+% bytes, cycles (4 phases), hist (32 buckets). Columns: update, downdate,
+% exchange
+icalls=1; ifails=2; iflops=4; icyc=6:9; ihist=10:41;
+
+choluprk1('reset'); choldnrk1('reset'); cholupexch('reset');
+for n=nvec
+  % Create matrix A with controlled spectrum
+  [q,r]=qr(randn(n,n));
+  a=muldiag(q,rand(n,1)*(maxlam-minlam)+minlam)*q';
+  lfact=chol(a)';
+  cvec=zeros(n,1); svec=zeros(n,1); wkvec=zeros(n,1);
+  for i=1:nup
+    vec=randn(n,1);
+    if choluprk1({lfact,[1 1 n n],'L '},vec,cvec,svec,wkvec)~=0
+      error('Numerical error in CHOLUPRK1!');
+    end
+  end
+  for i=1:(ndn+nrej)
+    % Downdate by v = alpha*L*u, |u|=1. Rejected iff alpha>=1
+    vec=randn(n,1); vec=vec/norm(vec);
+    if i<=ndn
+      vec=0.5*lfact*vec;
+    else
+      vec=2*lfact*vec;
+    end
+    stat=choldnrk1({lfact,[1 1 n n],'L '},vec,cvec,svec,wkvec);
+    if (i<=ndn)~=(stat==0)
+      error('Wrong return status of CHOLDNRK1!');
+    end
+  end
+  rfact=lfact';
+  for i=1:nex
+    k=floor(rand*(n-1))+1;
+    l=k+1+floor(rand*(n-k));
+    cholupexch(rfact,k,l,floor(rand*2)+1);
+  end
+end
+
+% Check counters
+% Each MEX file has its own counters
+su=choluprk1('stats'); sd=choldnrk1('stats'); se=cholupexch('stats');
+st=[su(:,1) sd(:,2) se(:,3)];
+if all(st(:)==0)
+  error('All counters zero. Compile with MEXFLAGS=-DCHOL_INSTRUMENT');
+end
+ncalls=length(nvec)*[nup ndn+nrej nex];
+hist=zeros(32,3);
+for n=nvec
+  hist(floor(log2(n))+1,:)=hist(floor(log2(n))+1,:)+ncalls/length(nvec);
+end
+fprintf(1,'Calls: %d %d %d (expected %d %d %d)\n',st(icalls,:),ncalls);
+fprintf(1,'Fails: %d %d %d (expected %d %d %d)\n',st(ifails,:),0, ...
+	length(nvec)*nrej,0);
+if any(st(icalls,:)~=ncalls) || any(st(ifails,:)~=[0 length(nvec)*nrej 0])
+  error('Wrong calls or fails counters!');
+end
+if any(any(st(ihist,:)~=hist))
+  error('Wrong histogram of n!');
+end
+if any(st(iflops,:)<=0) || any(sum(st(icyc,:),1)<=0)
+  error('Flops or cycles not counted!');
+end
+choluprk1('dump');
+
+% Reset
+choluprk1('reset'); choldnrk1('reset'); cholupexch('reset');
+st=[choluprk1('stats') choldnrk1('stats') cholupexch('stats')];
+if any(st(:)~=0)
+  error('Counters not zero after reset!');
+end
+fprintf(1,'OK\n');
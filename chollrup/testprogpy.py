@@ -0,0 +1,121 @@
+# Test program for the Python extension module pychollrup (make python)
+
+import threading
+import numpy as np
+import pychollrup
+
+n = 200
+r = 30
+maxlam = 2.0
+minlam = 0.1
+rng = np.random.default_rng()
+
+
+def randspd(n):
+    # Create matrix A with controlled spectrum
+    q, rr = np.linalg.qr(rng.standard_normal((n, n)))
+    return (q * (rng.random(n) * (maxlam - minlam) + minlam)) @ q.T
+
+
+def getlower(fact, uplo):
+    return np.tril(fact) if uplo == 'L' else np.triu(fact).T
+
+
+# Updates and downdates, all combinations of order and UPLO. Z, X have
+# the same order as the factor
+for order in ('F', 'C'):
+    for uplo in ('L', 'U'):
+        a = randspd(n)
+        lfact = np.linalg.cholesky(a)
+        fact = np.array(lfact if uplo == 'L' else lfact.T, order=order)
+        b = rng.standard_normal((r, n))
+        z = np.array(b @ np.linalg.inv(lfact.T), order=order)
+        for i in range(10):
+            vec = rng.standard_normal(n)
+            y = rng.standard_normal(r)
+            if i % 2 == 0:
+                a = a + np.outer(vec, vec)
+                b = b + np.outer(y, vec)
+                stat = pychollrup.uprk1(fact, vec, uplo, z=z, y=y)
+            else:
+                # Downdate by v = 0.5*L*u, |u|=1
+                vec = vec / np.linalg.norm(vec)
+                vec = 0.5 * np.linalg.cholesky(a) @ vec
+                a = a - np.outer(vec, vec)
+                b = b - np.outer(y, vec)
+                stat = pychollrup.dnrk1(fact, vec, uplo, z=z, y=y)
+            if stat != 0:
+                raise RuntimeError('Numerical error')
+        l_2 = np.linalg.cholesky(a)
+        print('order=%s, uplo=%s: Max. dist. L: %e, Z: %e' % (
+            order, uplo, abs(getlower(fact, uplo) - l_2).max(),
+            abs(z - b @ np.linalg.inv(l_2.T)).max()))
+
+# Downdate rendering A_ indefinite
+a = randspd(n)
+fact = np.asfortranarray(np.linalg.cholesky(a))
+vec = 2.0 * fact @ (np.ones(n) / np.sqrt(n))
+if pychollrup.dnrk1(fact, vec) != 1:
+    raise RuntimeError('Downdate should fail')
+
+# Exchange updates, R upper (DCHEX) and lower (L = R')
+for order in ('F', 'C'):
+    for uplo in ('U', 'L'):
+        a = randspd(n)
+        rfact = np.linalg.cholesky(a).T
+        fact = np.array(rfact if uplo == 'U' else rfact.T, order=order)
+        bz = rng.standard_normal((r, n))
+        z = np.array(bz @ np.linalg.inv(rfact), order=order)
+        for i in range(10):
+            k = int(rng.integers(1, n))
+            l = k + 1 + int(rng.integers(0, n - k))
+            # Both JOB values, then random
+            job = i + 1 if i < 2 else int(rng.integers(1, 3))
+            b = rng.standard_normal((n, 5))
+            x = np.array(np.linalg.solve(getlower(fact, uplo), b),
+                         order=order)
+            pychollrup.upexch(fact, k, l, job, uplo, x=x, z=z)
+            if job == 1:
+                ind = list(range(k - 1)) + [l - 1] + \
+                    list(range(k - 1, l - 1)) + list(range(l, n))
+            else:
+                ind = list(range(k - 1)) + list(range(k, l)) + [k - 1] + \
+                    list(range(l, n))
+            a = a[np.ix_(ind, ind)]
+            bz = bz[:, ind]
+            l_2 = np.linalg.cholesky(a)
+            x_2 = np.linalg.solve(l_2, b[ind])
+        print('order=%s, uplo=%s: Max. dist. R: %e, X: %e, Z: %e' % (
+            order, uplo, abs(getlower(fact, uplo) - l_2).max(),
+            abs(x - x_2).max(), abs(z - bz @ np.linalg.inv(l_2.T)).max()))
+
+# Updates of different factors in parallel threads (GIL released). With
+# -DCHOL_INSTRUMENT, no counts may be lost
+nthr = 4
+facts = [np.asfortranarray(np.linalg.cholesky(randspd(n)))
+         for j in range(nthr)]
+vecs = [rng.standard_normal((20, n)) for j in range(nthr)]
+amats = [f @ f.T + v.T @ v for f, v in zip(facts, vecs)]
+
+
+def worker(fact, vmat):
+    for vec in vmat:
+        pychollrup.uprk1(fact, vec)
+
+
+pychollrup.instr_reset()
+thrds = [threading.Thread(target=worker, args=(facts[j], vecs[j]))
+         for j in range(nthr)]
+for t in thrds:
+    t.start()
+for t in thrds:
+    t.join()
+print('Threads: Max. dist. L: %e' % max(
+    abs(np.tril(f) - np.linalg.cholesky(a)).max()
+    for f, a in zip(facts, amats)))
+stats = pychollrup.instr_stats()
+if stats.any():
+    print('Threads: update calls: %d (expected %d)' % (
+        stats[0, 0], nthr * vecs[0].shape[0]))
+    if stats[0, 0] != nthr * vecs[0].shape[0]:
+        raise RuntimeError('Instrumentation counts lost')
@@ -0,0 +1,93 @@
+n=200; r=3*n; nrec=100;
+maxlam=2; minlam=0.1;
+fname='teststream.bin'; fname2='teststream2.bin';
+ckfname='teststream.ck'; logfname='teststream.log';
+
+% Create matrix A with controlled spectrum
+[q,rr]=qr(randn(n,n));
+a=muldiag(q,rand(n,1)*(maxlam-minlam)+minlam)*q';
+rfact=chol(a);
+b=randn(r,n);
+z=b/rfact;
+
+% Write stream of updates, downdates and exchanges. We track A_, B_
+% s.t. Z_ R_ = B_. The first half of the stream is also written to
+% FNAME2, to simulate a crash
+fid=fopen(fname,'w'); fid2=fopen(fname2,'w');
+nrej=0;
+for i=1:nrec
+  typ=floor(rand*3)+1;
+  if typ==1
+    vec=randn(n,1); y=randn(r,1);
+    a=a+vec*vec'; b=b+y*vec';
+    rec=[1; vec; y];
+  elseif typ==2
+    % Downdate by v = alpha*R'*u, |u|=1. Rejected iff alpha>=1
+    vec=randn(n,1); vec=vec/norm(vec); y=randn(r,1);
+    if rand<0.1
+      vec=2*chol(a)'*vec; nrej=nrej+1;
+    else
+      vec=0.5*chol(a)'*vec;
+      a=a-vec*vec'; b=b-y*vec';
+    end
+    rec=[2; vec; y];
+  else
+    k=floor(rand*(n-1))+1;
+    l=k+1+floor(rand*(n-k));
+    job=floor(rand*2)+1;
+    if job==1
+      ind=[1:(k-1) l k:(l-1) (l+1):n];
+    else
+      ind=[1:(k-1) (k+1):l k (l+1):n];
+    end
+    a=a(ind,ind); b=b(:,ind);
+    rec=[3; k; l; job];
+  end
+  fwrite(fid,rec,'double');
+  if i<=nrec/2
+    fwrite(fid2,rec,'double');
+  end
+end
+fclose(fid); fclose(fid2);
+
+% Part before crash
+[stat,nrec1,nrej1]=cholstream({rfact,[1 1 n n],'U '},fname2,z,8, ...
+			      ckfname,25,logfname);
+if stat~=0
+  error('Error in CHOLSTREAM!');
+end
+% Restart from checkpoint
+[rfact,z,nskip]=cholckload(ckfname);
+fprintf(1,'Restart after %d records\n',nskip);
+[stat,nrec2,nrej2]=cholstream({rfact,[1 1 n n],'U '},fname,z,8, ...
+			      ckfname,25,logfname,nskip);
+if stat~=0
+  error('Error in CHOLSTREAM!');
+end
+fprintf(1,'Records: %d, rejected: %d (expected %d)\n',nrec2, ...
+	nrej1+nrej2,nrej);
+r_2=chol(a);
+fprintf(1,'Max. dist. R: %e\n',max(max(abs(triu(rfact)-r_2))));
+z_2=b/r_2;
+fprintf(1,'Max. dist. Z: %e\n',max(max(abs(z-z_2))));
+delete(fname); delete(fname2); delete(ckfname);
+
+% Numerical error: L singular, so a rank-3 batch of updates fails. NREC
+% must not count the batch, and the failure must be logged
+lfact=eye(n); lfact(2,2)=0; vec=ones(n,1); vec(2)=0;
+fid=fopen(fname,'w');
+fwrite(fid,[3; 2; 1; 1],'double');
+for i=1:3
+  fwrite(fid,[1; vec; zeros(r,1)],'double');
+end
+fwrite(fid,[3; 1; 2; 1],'double');
+fclose(fid);
+if exist(logfname,'file'), delete(logfname); end
+[stat,nrec1,nrej1]=cholstream({lfact,[1 1 n n],'L '},fname,zeros(r,n),8, ...
+			      '',0,logfname);
+logtxt=fileread(logfname);
+fprintf(1,'Numerical error: STAT=%d, NREC=%d, log:\n%s',stat,nrec1,logtxt);
+if stat~=1 || nrec1~=1 || nrej1~=1 || isempty(strfind(logtxt,'Records 2-4'))
+  error('Numerical error not reported correctly!');
+end
+delete(fname); delete(logfname);
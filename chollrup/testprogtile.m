@@ -0,0 +1,99 @@
+n=200; r=30; nrec=60;
+maxlam=2; minlam=0.1;
+% Tile sizes: 7 and 64 do not divide n, n (single tile), > n
+nbvec=[1 7 64 200 256];
+fname='testtile.bin'; ckfname='testtile.ck';
+cvec=zeros(n,1); svec=zeros(n,1); wkv=zeros(max(n,r),1);
+
+for nb=nbvec
+  % Create matrix A with controlled spectrum
+  [q,rr]=qr(randn(n,n));
+  a=muldiag(q,rand(n,1)*(maxlam-minlam)+minlam)*q';
+  rfact=chol(a);
+  b=randn(r,n);
+  z=b/rfact;
+
+  % Tiled factor holds R'
+  t=choltile({rfact,[1 1 n n],'U '},nb);
+
+  % Test updates, downdates and exchanges (both JOB) on the tiled
+  % factor. We track A_, B_ s.t. Z_ R_ = B_
+  for i=1:24
+    typ=mod(i-1,4)+1;
+    if typ==1
+      vec=randn(n,1); y=randn(r,1);
+      a=a+vec*vec'; b=b+y*vec';
+      if choluprk1({t,[n nb]},vec,cvec,svec,wkv,z,y)~=0
+	error('Numerical error in CHOLUPRK1!');
+      end
+    elseif typ==2
+      vec=randn(n,1); vec=0.5*chol(a)'*(vec/norm(vec)); y=randn(r,1);
+      a=a-vec*vec'; b=b-y*vec';
+      if choldnrk1({t,[n nb]},vec,cvec,svec,wkv,0,z,y)~=0
+	error('Numerical error in CHOLDNRK1!');
+      end
+    else
+      k=floor(rand*(n-1))+1;
+      l=k+1+floor(rand*(n-k));
+      job=typ-2;
+      if job==1
+	ind=[1:(k-1) l k:(l-1) (l+1):n];
+      else
+	ind=[1:(k-1) (k+1):l k (l+1):n];
+      end
+      bx=randn(n,3);
+      x=chol(a)'\bx;
+      cholupexch({t,[n nb]},k,l,job,x);
+      a=a(ind,ind); b=b(:,ind);
+      z=b/chol(a);
+      x_2=chol(a)'\bx(ind,:);
+      fprintf(1,'nb=%d, job=%d: Max. dist. X: %e\n',nb,job, ...
+	      max(max(abs(x-x_2))));
+    end
+    rr=zeros(n,n);
+    choltile({t,[n nb]},{rr,[1 1 n n],'U '});
+    fprintf(1,'nb=%d, typ=%d: Max. dist. R: %e, Z: %e\n',nb,typ, ...
+	    max(max(abs(rr-chol(a)))),max(max(abs(z-b/chol(a)))));
+  end
+
+  % CHOLSTREAM on the tiled factor, exchanges with random JOB
+  fid=fopen(fname,'w');
+  for i=1:nrec
+    typ=floor(rand*3)+1;
+    if typ==1
+      vec=randn(n,1); y=randn(r,1);
+      a=a+vec*vec'; b=b+y*vec';
+      rec=[1; vec; y];
+    elseif typ==2
+      vec=randn(n,1); vec=0.5*chol(a)'*(vec/norm(vec)); y=randn(r,1);
+      a=a-vec*vec'; b=b-y*vec';
+      rec=[2; vec; y];
+    else
+      k=floor(rand*(n-1))+1;
+      l=k+1+floor(rand*(n-k));
+      job=floor(rand*2)+1;
+      if job==1
+	ind=[1:(k-1) l k:(l-1) (l+1):n];
+      else
+	ind=[1:(k-1) (k+1):l k (l+1):n];
+      end
+      a=a(ind,ind); b=b(:,ind);
+      rec=[3; k; l; job];
+    end
+    fwrite(fid,rec,'double');
+  end
+  fclose(fid);
+  [stat,nrec2,nrej]=cholstream({t,[n nb]},fname,z,8,ckfname);
+  if stat~=0 || nrec2~=nrec || nrej~=0
+    error('Error in CHOLSTREAM!');
+  end
+  rr=zeros(n,n);
+  choltile({t,[n nb]},{rr,[1 1 n n],'U '});
+  fprintf(1,'nb=%d, stream: Max. dist. R: %e, Z: %e\n',nb, ...
+	  max(max(abs(rr-chol(a)))),max(max(abs(z-b/chol(a)))));
+  % Checkpoint of tiled factor is lower triangular
+  [lfact,z_2,nrec2,uplo]=cholckload(ckfname);
+  fprintf(1,'nb=%d, checkpoint (%s): Max. dist. L: %e\n',nb,uplo, ...
+	  max(max(abs(lfact-chol(a)'))));
+  delete(fname); delete(ckfname);
+end